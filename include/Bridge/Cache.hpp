@@ -0,0 +1,64 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BRIDGE_CACHE_HPP
+#define BRIDGE_CACHE_HPP
+
+#include "DDS.hpp"
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace Bridge {
+
+// Persistent double-dummy results keyed by packed deals
+//
+// The file is an open-addressing hash table that is memory-mapped as is, so
+// read-only caches can be shared between processes at no cost.  There must be
+// at most one writer to a file at a time.
+class Cache
+{
+  struct Storage;
+
+  std::string _path;
+  bool _writable;
+  std::unique_ptr<Storage> _storage;
+
+  void open();
+  void grow();
+
+public:
+  // Open or create a cache file
+  //
+  // A missing file is created on the first insertion if writable, or treated
+  // as an empty cache otherwise.
+  explicit Cache(std::string path, bool writable = true);
+  ~Cache();
+
+  // Number of cached deals
+  std::size_t size() const;
+
+  // Look up a deal whose unmasked strains are all solved
+  std::optional<Result> find(const Deal &deal, StrainMask mask = {}) const;
+
+  // Store results of unmasked strains, merging with previous ones
+  void insert(const Deal &deal, const Result &result, StrainMask mask = {});
+};
+
+} // namespace Bridge
+
+#endif
@@ -19,9 +19,15 @@
 #define BRIDGE_DDS_HPP
 
 #include "Deal.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
 #include <span>
 #include <vector>
 
+struct ddTableDeal;
 struct ddTableResults;
 
 namespace Bridge {
@@ -46,9 +52,10 @@ class Result
     std::uint16_t w : 4;
   };
 
-  PerStrain _strains[5];
+  PerStrain _strains[5] = {};
 
 public:
+  constexpr Result() = default;
   Result(const ::ddTableResults &);
 
   constexpr int operator()(Strain strain, Seat seat) const
@@ -63,9 +70,159 @@ public:
     }
     return 0;
   }
+
+  constexpr void set(Strain strain, Seat seat, int tricks)
+  {
+    PerStrain &result = _strains[static_cast<int>(strain)];
+
+    switch (seat) {
+      case Seat::N: result.n = tricks; break;
+      case Seat::E: result.e = tricks; break;
+      case Seat::S: result.s = tricks; break;
+      case Seat::W: result.w = tricks; break;
+    }
+  }
 };
 
-std::vector<Result> solve(std::span<const Deal> deals, StrainMask mask = {});
+// Tricks in nibbles, indexed by 4 * strain + seat, 10 bytes in total
+using PackedResult = std::array<std::uint8_t, 10>;
+
+PackedResult pack(const Result &);
+Result unpack(const PackedResult &);
+
+class Cache;
+
+// Convert a deal to the input of DDS
+::ddTableDeal convertToDDS(const Deal &);
+
+// Double-dummy question on a single contract
+struct Query
+{
+  Deal deal;
+  Strain strain;
+  Seat declarer;
+
+  // Tricks declarer needs, or -1 for the maximum
+  int target = -1;
+};
+
+// Answer queries in batches
+//
+// Deals asking for many contracts are solved as tables, restricted to the
+// strains in question.  Other queries go to DDS one board per contract,
+// which is cheaper when few contracts per deal are asked.
+//
+// The answer is the number of tricks taken by declarer, or for a query with
+// a target, 1 if declarer makes the target and 0 otherwise.  Errors of DDS
+// are thrown as std::runtime_error.
+std::vector<int> solve(std::span<const Query> queries);
+
+// Double-dummy tricks for declarer after each opening lead
+//
+// Cards are indexed by suit and rank from 2 to 14, as in Holding.  Cards not
+// held by the leader map to -1.
+class Leads
+{
+  std::array<std::int8_t, 52> _tricks;
+
+public:
+  Leads() { _tricks.fill(-1); }
+
+  int operator()(Strain suit, int rank) const { return _tricks[13 * static_cast<int>(suit) + rank - 2]; }
+  void set(Strain suit, int rank, int tricks) { _tricks[13 * static_cast<int>(suit) + rank - 2] = tricks; }
+};
+
+// Solve every opening lead against the contract of each query
+//
+// Queries go to DDS as boards in batches, which DDS spreads over its
+// threads.  Targets of queries are ignored.
+std::vector<Leads> solveLeads(std::span<const Query> queries);
+
+// Write deals to solve into the buffer and return how many are written.
+// Returning 0 ends the stream.
+using Source = std::function<std::size_t(std::span<Deal>)>;
+
+// Receive a pack of solved deals along with their results
+using Sink = std::function<void(std::span<const Deal>, std::span<const Result>)>;
+
+// Measurements of a pack solved by DDS
+//
+// While DDS solves a pack, the neighbouring packs are prepared and finished
+// on a helper thread.  Time not spent in DDS is overhead, of which the stall
+// is the part not hidden behind DDS.
+struct PackStats
+{
+  // Deals drawn from the source, and those sent to DDS
+  std::size_t deals = 0;
+  std::size_t solved = 0;
+
+  // Deals DDS takes in a full pack, and strains solved per deal
+  std::size_t capacity = 0;
+  std::size_t strains = 0;
+
+  std::chrono::nanoseconds wall {};
+  std::chrono::nanoseconds solver {};
+  std::chrono::nanoseconds stall {};
+
+  // Return code of DDS, where RETURN_NO_FAULT is 1
+  int error = 1;
+};
+
+// Totals over packs, cheap enough to collect for every solve
+struct SolveStats
+{
+  std::size_t packs = 0;
+  std::size_t deals = 0;
+  std::size_t solved = 0;
+  std::size_t capacity = 0;
+  std::size_t tables = 0;
+
+  std::chrono::nanoseconds wall {};
+  std::chrono::nanoseconds solver {};
+  std::chrono::nanoseconds stall {};
+
+  // Number of failed packs and the last error code
+  std::size_t failures = 0;
+  int error = 1;
+
+  SolveStats &operator+=(const PackStats &);
+  SolveStats &operator+=(const SolveStats &);
+};
+
+// Print a human-readable summary
+std::ostream &operator<<(std::ostream &, const SolveStats &);
+
+// Called with measurements of each pack on the thread calling solve
+using Observer = std::function<void(const PackStats &)>;
+
+// Limit DDS to the number of threads and memory in MB, where 0 lets DDS
+// decide.  DDS keeps one set of resources for the process, so call this
+// before solving rather than during a solve.
+void setResources(int threads = 0, int memory = 0);
+
+// Solve deals in packs of even sizes
+std::vector<Result> solve(std::span<const Deal> deals, StrainMask mask = {}, const Observer &observer = {});
+
+// Skip deals found in the cache and store newly solved ones
+std::vector<Result> solve(std::span<const Deal> deals, Cache &cache, StrainMask mask = {}, const Observer &observer = {});
+
+// Solve deals sharing holdings together, returning results in caller order
+//
+// Deals are sorted by their holdings, most shared columns first, before being
+// packed.  This pays off on correlated batches like completions of a partial
+// deal, where DDS reuses more of its search across a pack.
+std::vector<Result> solveClustered(std::span<const Deal> deals, StrainMask mask = {}, const Observer &observer = {});
+std::vector<Result> solveClustered(std::span<const Deal> deals, Cache &cache, StrainMask mask = {}, const Observer &observer = {});
+
+// Solve a stream of deals pack by pack
+//
+// While DDS is busy on a pack, the next pack is drawn from the source and
+// converted, and the previous pack is handed to the sink.  This work runs on
+// a helper thread kept for the whole stream, except that the first pack is
+// drawn and the last one sunk on the calling thread.  Callbacks may thus run
+// on either thread, but never concurrently and always in stream order.
+void solve(const Source &source, const Sink &sink, StrainMask mask = {}, const Observer &observer = {});
+void solve(const Source &source, const Sink &sink, Cache &cache, StrainMask mask = {}, const Observer &observer = {});
 
 } // namespace Bridge
 
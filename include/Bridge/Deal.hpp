@@ -50,6 +50,9 @@ class Holding
   std::uint16_t _data = 0;
 
 public:
+  Holding() = default;
+  constexpr explicit Holding(std::uint16_t bits) : _data(bits) {}
+
   std::uint16_t bits() const { return _data; }
   unsigned size() const { return __builtin_popcount(bits()); }
   bool empty() const { return !bits(); }
@@ -94,8 +97,32 @@ struct Deal : private std::array<Hand, 4>
   Hand & operator[](Seat seat) { return data()[static_cast<int>(seat)]; }
 };
 
+// Owner of each card in 2 bits, 13 bytes in total
+//
+// Card #i is the (i % 13 + 2) of suit i / 13, and byte #(i / 4) holds cards
+// from the least significant bits.
+using PackedDeal = std::array<std::uint8_t, 13>;
+
+PackedDeal pack(const Deal &);
+Deal unpack(const PackedDeal &);
+
+// Number of a deal in [0, 52! / 13!^4), which takes 96 bits
+//
+// North, East, and South in turn take a combination of the cards left,
+// numbered by the combinatorial number system.
+__extension__ typedef unsigned __int128 DealIndex;
+
+DealIndex getIndex(const Deal &);
+Deal getDeal(DealIndex);
+
+class Philox;
+
+// These functions are thread-safe.  Without a generator, each thread draws
+// from its own generator seeded by std::random_device.
 Deal getRandomDeal();
+Deal getRandomDeal(Philox &);
 void fillRandomCards(Deal &);
+void fillRandomCards(Deal &, Philox &);
 
 template <typename Ch>
 std::basic_ostream<Ch> & operator<<(std::basic_ostream<Ch> &stream, const Holding &holding)
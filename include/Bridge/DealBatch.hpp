@@ -0,0 +1,88 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BRIDGE_DEAL_BATCH_HPP
+#define BRIDGE_DEAL_BATCH_HPP
+
+#include "DDS.hpp"
+#include "Evaluator.hpp"
+#include <array>
+#include <span>
+#include <vector>
+
+namespace Bridge {
+
+enum class ShapeClass : std::uint8_t { Balanced, SemiBalanced, Unbalanced };
+
+// Deals stored as columns of holdings, one per seat and suit
+//
+// Kernels over the whole batch run on contiguous 16-bit columns, which
+// compilers vectorize.
+class DealBatch
+{
+  std::array<std::vector<std::uint16_t>, 16> _columns;
+
+public:
+  DealBatch() = default;
+  explicit DealBatch(std::span<const Deal> deals);
+
+  std::size_t size() const { return _columns[0].size(); }
+  bool empty() const { return _columns[0].empty(); }
+
+  void clear();
+  void reserve(std::size_t);
+  void push_back(const Deal &);
+
+  Deal operator[](std::size_t) const;
+  void set(std::size_t, const Deal &);
+
+  std::span<const std::uint16_t> column(Seat seat, Strain suit) const
+  {
+    return _columns[4 * static_cast<int>(seat) + static_cast<int>(suit)];
+  }
+
+  std::span<std::uint16_t> column(Seat seat, Strain suit)
+  {
+    return _columns[4 * static_cast<int>(seat) + static_cast<int>(suit)];
+  }
+
+  void getLengths(Seat, Strain, std::span<std::uint8_t>) const;
+
+  // Suit lengths in nibbles, clubs in the least significant one
+  void getShapes(Seat, std::span<std::uint16_t>) const;
+
+  void getShapeClasses(Seat, std::span<ShapeClass>) const;
+  void getHCP(Seat, std::span<int>) const;
+
+  // Aces count 2 and kings count 1
+  void getControls(Seat, std::span<int>) const;
+
+  template <typename T>
+  void evaluate(Seat seat, const Table<T> &table, std::span<T> points) const
+  {
+    std::fill(points.begin(), points.end(), T());
+
+    for (int suit = 0; suit < 4; ++suit)
+      table.accumulate(column(seat, Strain(suit)), points);
+  }
+};
+
+std::vector<Result> solve(const DealBatch &deals, StrainMask mask = {});
+
+} // namespace Bridge
+
+#endif
@@ -0,0 +1,108 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BRIDGE_DEAL_FILE_HPP
+#define BRIDGE_DEAL_FILE_HPP
+
+#include "DDS.hpp"
+#include "Notation.hpp"
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+
+namespace Bridge {
+
+// Binary file of packed deals, optionally followed by their results
+//
+// A 16-byte header holds the magic "BridgeDL", the size of a record, and
+// reserved flags.  Each record is a PackedDeal, followed by a PackedResult if
+// results are stored.  The number of records follows from the file size, so a
+// file cut short by a crash loses at most its last record.
+class DealWriter
+{
+  std::ofstream _stream;
+  std::string _path;
+  bool _results;
+
+public:
+  // Create or truncate a file
+  explicit DealWriter(std::string path, bool results = false);
+
+  // Append a record, throwing std::logic_error if results are expected
+  // but missing, or given but not stored
+  void write(const Deal &deal);
+  void write(const Deal &deal, const Result &result);
+
+  // Append records, where results are either empty or one per deal
+  void write(std::span<const Deal> deals, std::span<const Result> results = {});
+
+  // Flush written records, throwing on failure
+  void flush();
+};
+
+// Memory-mapped reader of a deal file
+//
+// Records are decoded straight from the mapping without parsing.
+class DealFile
+{
+  struct Storage;
+
+  std::unique_ptr<Storage> _storage;
+  const std::uint8_t *_records;
+  std::size_t _size;
+  std::size_t _stride;
+
+public:
+  explicit DealFile(const std::string &path);
+  ~DealFile();
+
+  std::size_t size() const { return _size; }
+  bool hasResults() const { return _stride > sizeof(PackedDeal); }
+
+  Deal operator[](std::size_t i) const;
+
+  // Stored result of a record, only if hasResults()
+  Result result(std::size_t i) const;
+
+  // Stream records [first, last) into a solve
+  Source source(std::size_t first = 0, std::size_t last = std::numeric_limits<std::size_t>::max()) const;
+};
+
+// Deals from a binary deal file if the path ends in ".bin", or else from any
+// text with PBN or LIN deals
+class DealReader
+{
+  std::unique_ptr<DealFile> _binary;
+  std::unique_ptr<DealText> _text;
+
+public:
+  explicit DealReader(const std::string &path);
+
+  std::size_t size() const { return _binary ? _binary->size() : _text->size(); }
+
+  // The binary file for random access and stored results, or null for text
+  const DealFile *binary() const { return _binary.get(); }
+
+  // Stream deals [first, last) into a solve
+  Source source(std::size_t first = 0, std::size_t last = std::numeric_limits<std::size_t>::max()) const;
+};
+
+} // namespace Bridge
+
+#endif
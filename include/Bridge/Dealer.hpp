@@ -0,0 +1,107 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BRIDGE_DEALER_HPP
+#define BRIDGE_DEALER_HPP
+
+#include "Deal.hpp"
+#include <array>
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace Bridge {
+
+class Philox;
+
+// Inclusive range of integers
+struct Range
+{
+  int min;
+  int max;
+
+  constexpr bool contains(int x) const { return min <= x && x <= max; }
+};
+
+// Suit lengths, indexed by Strain
+using Shape = std::array<int, 4>;
+
+Shape getShape(const Hand &);
+
+// 4333, 4432, or 5332
+bool isBalanced(const Shape &);
+
+// Requirements on a hand
+struct Constraint
+{
+  // Suit lengths, indexed by Strain
+  std::array<Range, 4> lengths = {{ { 0, 13 }, { 0, 13 }, { 0, 13 }, { 0, 13 } }};
+
+  // High card points
+  Range hcp = { 0, 37 };
+
+  // Additional requirement on suit lengths, resolved before dealing
+  std::function<bool(const Shape &)> shape;
+
+  // Residual requirement on the hand, e.g. on other evaluators
+  std::function<bool(const Hand &)> accept;
+};
+
+// Deal hands satisfying per-seat constraints
+//
+// Suit lengths of the seats with shape constraints are drawn from their exact
+// distribution among all deals, and then cards are filled in.  Deals are only
+// rejected on points and residual predicates.  If the constraints are too
+// mild to enumerate their layouts, deals are drawn by rejection instead.
+class Dealer
+{
+  std::array<Constraint, 4> _constraints;
+  std::function<bool(const Deal &)> _accept;
+
+  // Seats with shape constraints
+  std::vector<Seat> _shaped;
+
+  // Feasible lengths of the shaped seats, 4 suits per seat, or empty for
+  // rejection sampling
+  std::vector<std::array<unsigned char, 16>> _layouts;
+  std::vector<double> _cumulative;
+  double _probability;
+
+  bool checkResidual(const Deal &) const;
+
+public:
+  explicit Dealer(const std::array<Constraint, 4> &constraints, std::function<bool(const Deal &)> accept = {});
+
+  // Probability that a random deal satisfies the shape constraints, excluding
+  // layouts of suit lengths where no hand can meet the HCP ranges.  This is
+  // NaN when deals are drawn by rejection.
+  double probability() const { return _probability; }
+
+  // Check a deal against all constraints
+  bool accepts(const Deal &) const;
+
+  // Draw a deal, throwing std::runtime_error if none is accepted after 2^24
+  // tries, as happens when points or residual predicates cannot be met
+  Deal operator()(Philox &) const;
+
+  // Fill deals with consecutive deals of a reproducible run
+  void operator()(std::span<Deal> deals, std::uint64_t seed, std::uint64_t first = 0) const;
+};
+
+} // namespace Bridge
+
+#endif
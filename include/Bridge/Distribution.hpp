@@ -0,0 +1,178 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BRIDGE_DISTRIBUTION_HPP
+#define BRIDGE_DISTRIBUTION_HPP
+
+#include "Deal.hpp"
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Bridge {
+
+// Exact distribution of a suit-additive evaluation of a random hand
+//
+// An evaluator maps a holding to a value, and a hand is worth the sum over
+// its suits, as in apply().  Holdings are tabulated by length and value, and
+// suits are convolved so that the hand has 13 cards.  For the combined hands
+// of a partnership, holdings are tabulated in disjoint pairs instead.  Counts
+// are exact, as there are fewer than 2^73 partnership hands.
+//
+// Values returned as std::pair add componentwise, giving joint distributions
+// of two evaluators.
+template <typename K>
+class Distribution
+{
+public:
+  __extension__ typedef unsigned __int128 Count;
+
+private:
+  // Counts by value, indexed by the lengths of the hands
+  using Grid = std::vector<std::map<K, Count>>;
+
+  std::map<K, Count> _counts;
+  Count _total = 0;
+
+  static K add(const K &x, const K &y)
+  {
+    if constexpr (requires { x.first; x.second; })
+      return K(x.first + y.first, x.second + y.second);
+    else
+      return x + y;
+  }
+
+  // Convolve a grid with itself, dropping hands longer than 13 cards
+  //
+  // Addition commutes, so cells i < j are visited once and counted twice.
+  static Grid square(const Grid &x)
+  {
+    Grid z(x.size());
+
+    for (std::size_t i = 0; i < x.size(); ++i) {
+      for (std::size_t j = i; j < x.size(); ++j) {
+        if (x[i].empty() || x[j].empty() || i % 14 + j % 14 > 13 || i / 14 + j / 14 > 13)
+          continue;
+
+        std::map<K, Count> &target = z[i + j];
+        const Count twice = 1 + (i < j);
+
+        // Sums with a fixed u are in order, so each lands next to the last
+        for (const auto &[u, m] : x[i]) {
+          auto hint = target.begin();
+
+          for (const auto &[v, n] : x[j]) {
+            hint = target.try_emplace(hint, add(u, v));
+            hint++->second += twice * m * n;
+          }
+        }
+      }
+    }
+
+    return z;
+  }
+
+public:
+  // Distribution over a hand, or over a partnership if hands is 2
+  template <typename F>
+  explicit Distribution(const F &f, int hands = 1)
+  {
+    if (hands != 1 && hands != 2)
+      throw std::invalid_argument("Distribution over 1 or 2 hands");
+
+    std::vector<K> values;
+    values.reserve(8192);
+
+    for (unsigned bits = 0; bits < 8192; ++bits)
+      values.push_back(f(Holding(bits << 2)));
+
+    // A cell holds lengths l of one hand or l1 + 14 * l2 of two
+    Grid suit(hands == 1 ? 14 : 196);
+
+    for (unsigned x = 0; x < 8192; ++x) {
+      if (hands == 1) {
+        ++suit[__builtin_popcount(x)][values[x]];
+        continue;
+      }
+
+      // Every subset of the remaining cards
+      const unsigned rest = 8191 & ~x;
+
+      for (unsigned y = rest;; y = (y - 1) & rest) {
+        ++suit[__builtin_popcount(x) + 14 * __builtin_popcount(y)][add(values[x], values[y])];
+
+        if (!y)
+          break;
+      }
+    }
+
+    // Meet in the middle: two suits, then the other two making up 13 cards
+    // in each hand, which is the cell mirrored through the center
+    const Grid pair = square(suit);
+
+    for (std::size_t i = 0; i < pair.size(); ++i)
+      for (const auto &[u, m] : pair[i])
+        for (const auto &[v, n] : pair[pair.size() - 1 - i])
+          _counts[add(u, v)] += m * n;
+
+    for (const auto &entry : _counts)
+      _total += entry.second;
+  }
+
+  // Number of hands with each value, and in total
+  const std::map<K, Count> &counts() const { return _counts; }
+  Count total() const { return _total; }
+
+  double probability(const K &value) const
+  {
+    const auto found = _counts.find(value);
+    return found == _counts.end() ? 0 : double(found->second) / double(_total);
+  }
+
+  double mean() const requires std::is_arithmetic_v<K>
+  {
+    double sum = 0;
+
+    for (const auto &[value, count] : _counts)
+      sum += double(value) * double(count);
+
+    return sum / double(_total);
+  }
+
+  double variance() const requires std::is_arithmetic_v<K>
+  {
+    const double mu = mean();
+    double sum = 0;
+
+    for (const auto &[value, count] : _counts)
+      sum += (double(value) - mu) * (double(value) - mu) * double(count);
+
+    return sum / double(_total);
+  }
+
+  double stddev() const requires std::is_arithmetic_v<K> { return std::sqrt(variance()); }
+};
+
+template <typename F>
+Distribution(const F &, int = 1) -> Distribution<decltype(std::declval<F>()(Holding()))>;
+
+} // namespace Bridge
+
+#endif
@@ -0,0 +1,62 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BRIDGE_ENUMERATOR_HPP
+#define BRIDGE_ENUMERATOR_HPP
+
+#include "Deal.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Bridge {
+
+// Every completion of a partial deal, numbered from 0
+//
+// Completions are ranked in a mixed radix of combinations: the unknown cards
+// of each hidden seat in turn are a combination of the cards left, numbered
+// by the combinatorial number system.  This is a bijection, so any range of
+// indices can be unranked independently.
+class Enumerator
+{
+  Deal _partial;
+
+  // Unknown cards in ascending order, and the number each seat receives
+  std::vector<Card> _cards;
+  std::array<int, 4> _slots;
+
+  std::uint64_t _size;
+
+public:
+  explicit Enumerator(const Deal &partial);
+
+  // Number of completions, saturated at the maximum of std::uint64_t
+  std::uint64_t size() const { return _size; }
+
+  // Completion of the index
+  Deal operator[](std::uint64_t index) const;
+
+  // Index of a completion
+  std::uint64_t rank(const Deal &deal) const;
+
+  // Unrank completions [first, first + deals.size()) in parallel
+  void operator()(std::span<Deal> deals, std::uint64_t first = 0) const;
+};
+
+} // namespace Bridge
+
+#endif
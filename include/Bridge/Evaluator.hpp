@@ -15,8 +15,20 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
+#ifndef BRIDGE_EVALUATOR_HPP
+#define BRIDGE_EVALUATOR_HPP
+
 #include "Deal.hpp"
 #include <Eigen/Core>
+#include <algorithm>
+#include <array>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 namespace Bridge {
 
@@ -63,4 +75,122 @@ const Evaluator<float> BUMRAP { 4.5f, 3.0f, 1.5f, 0.75f, 0.25f };
 // We use 10x values to avoid floating-point errors
 const Evaluator<int> Fifths { 40, 28, 18, 10, 4 };
 
+// Losing trick count
+inline int ltc(Holding holding)
+{
+  const int length = std::min<int>(holding.size(), 3);
+  return length - __builtin_popcount(holding.bits() >> (15 - length));
+}
+
+// New losing trick count
+inline float nltc(Holding holding)
+{
+  const auto length = holding.size();
+
+  return 1.5f * (length >= 1 && !holding.test(14))
+       + 1.0f * (length >= 2 && !holding.test(13))
+       + 0.5f * (length >= 3 && !holding.test(12));
+}
+
+// NLTC capped by suit length
+inline float altc(Holding holding)
+{
+  return std::min<float>(nltc(holding), holding.size());
+}
+
+// Suit evaluator tabulated over all 8192 holdings
+template <typename T>
+class Table
+{
+  std::array<T, 8192> _values;
+
+public:
+  template <typename F>
+  explicit Table(const F &f)
+  {
+    for (unsigned i = 0; i < _values.size(); ++i)
+      _values[i] = f(Holding(i << 2));
+  }
+
+  T operator()(Holding holding) const { return _values[holding.bits() >> 2]; }
+
+  // Evaluate a batch of hands
+  //
+  // 8 hands at a time are evaluated with AVX2 gathers if enabled, e.g. by
+  // -march=native.
+  void operator()(std::span<const Hand> hands, std::span<T> points) const
+  {
+    std::size_t i = 0;
+
+#ifdef __AVX2__
+    if constexpr (std::is_same_v<T, int> || std::is_same_v<T, float>) {
+      const auto *data = reinterpret_cast<const __m128i *>(hands.data());
+      const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+      for (; i + 8 <= hands.size(); i += 8, data += 4) {
+        // Each vector holds 4 suits of 2 hands
+        const auto gather = [this](const __m128i *pair)
+        {
+          const __m256i indices = _mm256_srli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128(pair)), 2);
+
+          if constexpr (std::is_same_v<T, int>)
+            return _mm256_i32gather_epi32(_values.data(), indices, 4);
+          else
+            return _mm256_i32gather_ps(_values.data(), indices, 4);
+        };
+
+        if constexpr (std::is_same_v<T, int>) {
+          const __m256i sums = _mm256_hadd_epi32(
+              _mm256_hadd_epi32(gather(data), gather(data + 1)),
+              _mm256_hadd_epi32(gather(data + 2), gather(data + 3)));
+          _mm256_storeu_si256(reinterpret_cast<__m256i *>(points.data() + i), _mm256_permutevar8x32_epi32(sums, order));
+        }
+        else {
+          const __m256 sums = _mm256_hadd_ps(
+              _mm256_hadd_ps(gather(data), gather(data + 1)),
+              _mm256_hadd_ps(gather(data + 2), gather(data + 3)));
+          _mm256_storeu_ps(points.data() + i, _mm256_permutevar8x32_ps(sums, order));
+        }
+      }
+    }
+#endif
+
+    for (; i < hands.size(); ++i)
+      points[i] = apply(*this, hands[i]);
+  }
+
+  // Add values of a column of holdings to the points
+  void accumulate(std::span<const std::uint16_t> holdings, std::span<T> points) const
+  {
+    std::size_t i = 0;
+
+#ifdef __AVX2__
+    if constexpr (std::is_same_v<T, int> || std::is_same_v<T, float>) {
+      for (; i + 8 <= holdings.size(); i += 8) {
+        const __m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i *>(holdings.data() + i));
+        const __m256i indices = _mm256_srli_epi32(_mm256_cvtepu16_epi32(bits), 2);
+
+        if constexpr (std::is_same_v<T, int>) {
+          auto *target = reinterpret_cast<__m256i *>(points.data() + i);
+          const __m256i values = _mm256_i32gather_epi32(_values.data(), indices, 4);
+          _mm256_storeu_si256(target, _mm256_add_epi32(_mm256_loadu_si256(target), values));
+        }
+        else {
+          const __m256 values = _mm256_i32gather_ps(_values.data(), indices, 4);
+          _mm256_storeu_ps(points.data() + i, _mm256_add_ps(_mm256_loadu_ps(points.data() + i), values));
+        }
+      }
+    }
+#endif
+
+    for (; i < holdings.size(); ++i)
+      points[i] += _values[holdings[i] >> 2];
+  }
+};
+
+template <typename F>
+Table(const F &) -> Table<decltype(std::declval<F>()(Holding()))>;
+
 } // namespace Bridge
+
+#endif
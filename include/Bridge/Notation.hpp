@@ -0,0 +1,73 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BRIDGE_NOTATION_HPP
+#define BRIDGE_NOTATION_HPP
+
+#include "DDS.hpp"
+#include <charconv>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace Bridge {
+
+// Parse a PBN deal like "N:AKQ.JT9.876.5432 ..." in the manner of
+// std::from_chars.  Hands start from the given seat and go clockwise, where
+// "-" stands for an unknown hand.  Known hands must have 13 cards.
+std::from_chars_result parsePBN(const char *first, const char *last, Deal &deal);
+
+// Parse a LIN deal like "md|3SAKQHJT9D876C5432,...|", with or without
+// "md|".  Hands start from South and go clockwise.  The last hand is
+// completed from the other three if omitted.
+std::from_chars_result parseLIN(const char *first, const char *last, Deal &deal);
+
+// Format a deal like operator<< does in the manner of std::to_chars, except
+// that an empty hand is written as "-" for parsePBN to read it back.  A deal
+// takes at most 69 characters.
+std::to_chars_result formatPBN(char *first, char *last, const Deal &deal);
+
+// Find the next line with a deal, which is either a PBN deal tag, a bare PBN
+// deal, or a LIN record with md.  Lines that merely start like a bare PBN
+// deal are skipped.  Return past the line, or last with
+// std::errc::result_out_of_range if there is no more deal.
+std::from_chars_result scanDeal(const char *first, const char *last, Deal &deal);
+
+// Memory-mapped text file of deals, one per line among other lines
+class DealText
+{
+  struct Storage;
+
+  std::unique_ptr<Storage> _storage;
+  std::string_view _text;
+  std::size_t _size;
+
+public:
+  // Map the file and count deals, throwing on malformed or incomplete ones
+  explicit DealText(const std::string &path);
+  ~DealText();
+
+  std::size_t size() const { return _size; }
+
+  // Stream deals [first, last) into a solve
+  Source source(std::size_t first = 0, std::size_t last = std::numeric_limits<std::size_t>::max()) const;
+};
+
+} // namespace Bridge
+
+#endif
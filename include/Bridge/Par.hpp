@@ -0,0 +1,66 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BRIDGE_PAR_HPP
+#define BRIDGE_PAR_HPP
+
+#include "DDS.hpp"
+#include <array>
+
+namespace Bridge {
+
+enum class Vulnerability { None, NS, EW, Both };
+
+// Final contract, where level 0 means passed out
+struct Contract
+{
+  int level = 0;
+  Strain strain = Strain::N;
+  Seat declarer = Seat::N;
+  bool doubled = false;
+};
+
+// Duplicate score for declarer
+int getScore(const Contract &contract, int tricks, bool vulnerable);
+
+// Par result, scored for NS
+struct Par
+{
+  int score = 0;
+  Contract contract;
+};
+
+// Par from a double-dummy table
+//
+// Par is the outcome of an auction where both sides know the table, making
+// contracts are left undoubled, and failing ones are doubled.  The dealer
+// only matters when both sides can make the same contract.  Pass the mask of
+// the solve so that contracts in unsolved strains are not considered.
+Par getPar(const Result &result, Vulnerability vulnerability, Seat dealer = Seat::N, StrainMask mask = {});
+
+// Par for every vulnerability, indexed by Vulnerability
+std::array<Par, 4> getPar(const Result &result, Seat dealer = Seat::N, StrainMask mask = {});
+
+// Par of a batch in parallel
+//
+// This is cheap enough to run in the sink of a streaming solve, where it
+// overlaps with DDS working on the next pack.
+std::vector<std::array<Par, 4>> getPar(std::span<const Result> results, Seat dealer = Seat::N, StrainMask mask = {});
+
+} // namespace Bridge
+
+#endif
@@ -0,0 +1,164 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BRIDGE_RANDOM_HPP
+#define BRIDGE_RANDOM_HPP
+
+#include "Deal.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+namespace Bridge {
+
+// Philox4x32-10 counter-based random number generator
+//
+// The output is a pure function of (seed, stream, position), so independent
+// streams can be split from one seed and any position can be reached in O(1).
+// https://www.thesalmons.org/john/random123/papers/random123sc11.pdf
+class Philox
+{
+  std::array<std::uint32_t, 4> _counter;
+  std::array<std::uint32_t, 2> _key;
+  std::array<std::uint32_t, 4> _block = {};
+  unsigned _index = 4;
+
+  static constexpr std::array<std::uint32_t, 4> round(
+      std::array<std::uint32_t, 4> counter, std::array<std::uint32_t, 2> key)
+  {
+    const std::uint64_t p = std::uint64_t{0xD2511F53} * counter[0];
+    const std::uint64_t q = std::uint64_t{0xCD9E8D57} * counter[2];
+
+    return {
+      static_cast<std::uint32_t>(q >> 32) ^ counter[1] ^ key[0],
+      static_cast<std::uint32_t>(q),
+      static_cast<std::uint32_t>(p >> 32) ^ counter[3] ^ key[1],
+      static_cast<std::uint32_t>(p),
+    };
+  }
+
+  void refill()
+  {
+    std::array<std::uint32_t, 2> key = _key;
+    _block = _counter;
+
+    for (int i = 0; i < 10; ++i) {
+      _block = round(_block, key);
+      key[0] += 0x9E3779B9;
+      key[1] += 0xBB67AE85;
+    }
+
+    if (!++_counter[0])
+      ++_counter[1];
+
+    _index = 0;
+  }
+
+public:
+  using result_type = std::uint32_t;
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+  explicit Philox(std::uint64_t seed, std::uint64_t stream = 0)
+    : _counter {
+      0, 0,
+      static_cast<std::uint32_t>(stream),
+      static_cast<std::uint32_t>(stream >> 32),
+    },
+    _key {
+      static_cast<std::uint32_t>(seed),
+      static_cast<std::uint32_t>(seed >> 32),
+    }
+  {}
+
+  result_type operator()()
+  {
+    if (_index == 4)
+      refill();
+
+    return _block[_index++];
+  }
+
+  // Jump ahead in constant time
+  void discard(unsigned long long count)
+  {
+    const bool active = _index < 4;
+    const unsigned long long offset = count + (active ? _index : 0);
+    const std::uint64_t block = (static_cast<std::uint64_t>(_counter[1]) << 32 | _counter[0])
+      - active + offset / 4;
+
+    _counter[0] = static_cast<std::uint32_t>(block);
+    _counter[1] = static_cast<std::uint32_t>(block >> 32);
+    _index = 4;
+
+    if (offset % 4) {
+      refill();
+      _index = offset % 4;
+    }
+  }
+};
+
+// Unbiased integer in [0, bound) by Lemire's method
+//
+// Unlike std::uniform_int_distribution, this is identical across standard
+// libraries, which keeps seeded runs reproducible everywhere.
+inline std::uint32_t getUniform(Philox &generator, std::uint32_t bound)
+{
+  std::uint64_t product = static_cast<std::uint64_t>(generator()) * bound;
+
+  if (static_cast<std::uint32_t>(product) < bound) {
+    const std::uint32_t threshold = -bound % bound;
+
+    while (static_cast<std::uint32_t>(product) < threshold)
+      product = static_cast<std::uint64_t>(generator()) * bound;
+  }
+
+  return product >> 32;
+}
+
+// Uniform real number in [0, 1) with 53 random bits
+inline double getCanonical(Philox &generator)
+{
+  const std::uint64_t high = generator();
+  const std::uint64_t low = generator();
+  return ((high << 32 | low) >> 11) * 0x1p-53;
+}
+
+// Fisher-Yates shuffle, reproducible across standard libraries
+template <typename RandomIt>
+void shuffle(RandomIt first, RandomIt last, Philox &generator)
+{
+  for (auto size = last - first; size > 1; --size)
+    std::iter_swap(first + (size - 1), first + getUniform(generator, size));
+}
+
+// Fill deals with consecutive deals of a reproducible run
+//
+// Deal #i of the run with a given seed depends only on (seed, i), so any
+// shard of a run can be regenerated bit-for-bit.  Work is spread across all
+// hardware threads.
+void getRandomDeals(std::span<Deal> deals, std::uint64_t seed, std::uint64_t first = 0);
+
+// Complete partial deals with consecutive streams of a reproducible run
+void fillRandomCards(std::span<Deal> deals, std::uint64_t seed, std::uint64_t first = 0);
+
+} // namespace Bridge
+
+#endif
@@ -0,0 +1,76 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BRIDGE_RESULT_BATCH_HPP
+#define BRIDGE_RESULT_BATCH_HPP
+
+#include "DDS.hpp"
+#include <array>
+#include <span>
+#include <vector>
+
+namespace Bridge {
+
+// Double-dummy results stored as columns of tricks, one per strain and seat
+//
+// Tricks are packed in nibbles, two deals per byte, with the earlier deal in
+// the low nibble.  Aggregates run on whole columns, with AVX2 if enabled, and
+// optionally count only deals selected by a filter of one byte per deal,
+// where nonzero selects the deal.
+class ResultBatch
+{
+  std::array<std::vector<std::uint8_t>, 20> _columns;
+  std::size_t _size = 0;
+
+public:
+  // Number of deals taking each number of tricks
+  using Histogram = std::array<std::size_t, 14>;
+
+  ResultBatch() = default;
+  explicit ResultBatch(std::span<const Result> results);
+
+  std::size_t size() const { return _size; }
+  bool empty() const { return !_size; }
+
+  void clear();
+  void reserve(std::size_t);
+  void push_back(const Result &);
+
+  Result operator[](std::size_t) const;
+  void set(std::size_t, const Result &);
+
+  // Packed tricks of declarer in a strain, where the unused high nibble of an
+  // odd-sized column is 15
+  std::span<const std::uint8_t> column(Strain strain, Seat seat) const
+  {
+    return _columns[4 * static_cast<int>(strain) + static_cast<int>(seat)];
+  }
+
+  Histogram histogram(Strain, Seat, std::span<const std::uint8_t> filter = {}) const;
+
+  // Average tricks of selected deals
+  double mean(Strain, Seat, std::span<const std::uint8_t> filter = {}) const;
+
+  // Number and proportion of selected deals where declarer takes at least
+  // this many tricks, e.g. 10 for a game in a major
+  std::size_t count(Strain, Seat, int tricks, std::span<const std::uint8_t> filter = {}) const;
+  double probability(Strain, Seat, int tricks, std::span<const std::uint8_t> filter = {}) const;
+};
+
+} // namespace Bridge
+
+#endif
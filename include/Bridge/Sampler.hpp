@@ -0,0 +1,91 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BRIDGE_SAMPLER_HPP
+#define BRIDGE_SAMPLER_HPP
+
+#include "Deal.hpp"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace Bridge {
+
+// Weighted completions of a partial deal
+//
+// Every mode draws from the uniform distribution of completions, and differs
+// only in how draws are correlated to cut variance.  Sample i is a pure
+// function of (seed, i), so samples can be drawn in parallel or resumed.
+class Sampler
+{
+public:
+  enum class Mode
+  {
+    // Independent completions
+    Plain,
+
+    // Consecutive pairs where two hidden seats swap their dealt cards.  The
+    // seats must receive the same number of cards.
+    Antithetic,
+
+    // Exactly two hidden seats, where suit splits between them are strata
+    // allocated in proportion to their exact probabilities.  Error estimates
+    // do not credit stratification, so they are conservative.
+    Stratified,
+  };
+
+  // Relative probability of a completion under the actual distribution, e.g.
+  // from the bidding.  Its values become importance weights, where 0 rejects
+  // the completion.  It is called from multiple threads.
+  using Likelihood = std::function<double(const Deal &)>;
+
+private:
+  Deal _partial;
+  Mode _mode;
+  Likelihood _likelihood;
+
+  // Seats receiving unknown cards in antithetic and stratified modes
+  std::array<Seat, 2> _hidden;
+
+  // Lengths of the first hidden seat in each stratum, and cumulative
+  // probabilities of strata
+  std::vector<std::array<int, 4>> _strata;
+  std::vector<double> _cumulative;
+
+  Deal stratify(std::uint64_t seed, std::uint64_t index) const;
+
+public:
+  explicit Sampler(const Deal &partial, Mode mode = Mode::Plain, Likelihood likelihood = {});
+
+  const Deal &partial() const { return _partial; }
+
+  // Importance weight of a completion
+  double weigh(const Deal &deal) const { return _likelihood ? _likelihood(deal) : 1; }
+
+  // Number of consecutive samples correlated by design, which should be
+  // treated as one observation in error estimates
+  std::size_t group() const { return _mode == Mode::Antithetic ? 2 : 1; }
+
+  // Draw samples [first, first + deals.size()) along with their weights
+  void operator()(std::span<Deal> deals, std::span<double> weights, std::uint64_t seed, std::uint64_t first = 0) const;
+};
+
+} // namespace Bridge
+
+#endif
@@ -0,0 +1,146 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BRIDGE_SINGLE_DUMMY_HPP
+#define BRIDGE_SINGLE_DUMMY_HPP
+
+#include "Par.hpp"
+#include "Sampler.hpp"
+#include "Statistics.hpp"
+#include <array>
+#include <cstdint>
+
+namespace Bridge {
+
+// Options of single-dummy analysis
+struct Sampling
+{
+  Vulnerability vulnerability = Vulnerability::None;
+
+  // Stop when the best contract leads every other by this many standard
+  // errors.  The threshold is conservative because it is checked after
+  // every pack.
+  double z = 2.5;
+
+  // Bounds on the number of drawn deals, of which those of zero weight are
+  // not solved
+  std::size_t minimum = 64;
+  std::size_t maximum = 10000;
+
+  // Solve every completion instead when there are at most this many
+  std::uint64_t exhaustive = 10000;
+
+  std::uint64_t seed = 0;
+};
+
+// Outcome of candidate contracts over sampled deals
+struct Analysis
+{
+  std::vector<Contract> contracts;
+
+  // Distribution of tricks taken by declarer, indexed like contracts
+  std::vector<std::array<double, 14>> tricks;
+
+  // Mean and covariance of scores for declarer, indexed like contracts
+  Moments<> scores;
+
+  // Sum of squared weights for the effective sample size
+  double squares = 0;
+
+  // Index of the contract with the best mean score
+  std::size_t best = 0;
+
+  // Whether the best contract is statistically settled
+  bool settled = false;
+
+  // Whether every completion is solved, so that the analysis is exact
+  bool exact = false;
+
+  explicit Analysis(std::span<const Contract> contracts);
+
+  // Add a solved deal
+  void add(const Result &result, Vulnerability vulnerability, double weight = 1);
+
+  // Add correlated deals as one observation of their weighted mean score
+  void add(std::span<const Result> results, std::span<const double> weights, Vulnerability vulnerability);
+
+  // Kish's effective sample size of weighted deals
+  double size() const { return scores.weight() * scores.weight() / squares; }
+
+  // Standard error of the mean score of a contract
+  double error(std::size_t i) const;
+
+  // Standard error of the mean score difference of two contracts
+  double error(std::size_t i, std::size_t j) const;
+
+  // Probability that a contract makes
+  double probability(std::size_t i) const;
+
+  // Find the best contract and test whether it leads the others by z
+  // standard errors of paired differences
+  void decide(double z);
+};
+
+// Compare contracts over completions of a partial deal
+//
+// Unknown cards are dealt at random and solved pack by pack.  Sampling stops
+// as soon as the best contract is settled, or at the maximum.  Comparing
+// contracts on the same deals cancels most of the noise of dealing, so the
+// decision usually needs far fewer deals than estimating each contract
+// alone.  Contracts should be alternatives for the same side.
+//
+// When there are few unknown cards, every completion is solved instead,
+// which is both exact and faster than sampling to the same accuracy.
+Analysis analyze(const Deal &partial, std::span<const Contract> contracts, const Sampling &options = {});
+
+// Compare contracts over weighted samples, e.g. with variance reduction
+Analysis analyze(const Sampler &sampler, std::span<const Contract> contracts, const Sampling &options = {});
+
+// Outcome of opening leads against a contract over sampled deals
+//
+// Cards are indexed by 13 * suit + rank - 2.  A card only counts deals where
+// the leader holds it, which is every deal when the hand of the leader is
+// known.
+struct LeadAnalysis
+{
+  Contract contract;
+
+  // Weighted sums of deals, of tricks taken by declarer, and of deals where
+  // the lead defeats the contract
+  std::array<double, 52> weights = {};
+  std::array<double, 52> tricks = {};
+  std::array<double, 52> sets = {};
+
+  explicit LeadAnalysis(const Contract &contract) : contract(contract) {}
+
+  void add(const Leads &leads, double weight = 1);
+
+  // Mean tricks for declarer after the lead
+  double mean(Strain suit, int rank) const;
+
+  // Probability that the lead defeats the contract
+  double probability(Strain suit, int rank) const;
+};
+
+// Solve every opening lead over a number of completions of a partial deal,
+// skipping those of zero weight
+LeadAnalysis analyzeLeads(const Deal &partial, const Contract &contract, std::size_t number, std::uint64_t seed = 0);
+LeadAnalysis analyzeLeads(const Sampler &sampler, const Contract &contract, std::size_t number, std::uint64_t seed = 0);
+
+} // namespace Bridge
+
+#endif
@@ -0,0 +1,146 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BRIDGE_STATISTICS_HPP
+#define BRIDGE_STATISTICS_HPP
+
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+
+namespace Bridge {
+
+// Streaming mean and covariance of weighted observations
+//
+// Observations are added one by one with Welford's update or a batch at a
+// time, and partial moments from other threads or shards are combined with
+// merge().  Memory is constant in the number of observations.
+//
+// https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance
+template <int N = Eigen::Dynamic>
+class Moments
+{
+public:
+  using Vector = Eigen::Matrix<double, N, 1>;
+  using Matrix = Eigen::Matrix<double, N, N>;
+
+private:
+  double _weight = 0;
+  Vector _mean;
+
+  // Weighted sum of outer products of deviations from the mean
+  Matrix _comoment;
+
+public:
+  explicit Moments(Eigen::Index size = N)
+    : _mean(Vector::Zero(size)), _comoment(Matrix::Zero(size, size))
+  {}
+
+  // Moments of a batch of observations in rows, in two passes
+  template <typename Derived>
+  explicit Moments(const Eigen::MatrixBase<Derived> &observations)
+    : _weight(observations.rows()),
+      _mean(Vector::Zero(observations.cols())),
+      _comoment(Matrix::Zero(observations.cols(), observations.cols()))
+  {
+    // The mean of no rows would be 0/0
+    if (observations.rows()) {
+      _mean = observations.colwise().mean().transpose();
+      const auto centered = (observations.rowwise() - _mean.transpose()).eval();
+      _comoment.noalias() = centered.transpose() * centered;
+    }
+  }
+
+  Eigen::Index size() const { return _mean.size(); }
+  double weight() const { return _weight; }
+  const Vector &mean() const { return _mean; }
+  const Matrix &comoment() const { return _comoment; }
+
+  template <typename Derived>
+  void add(const Eigen::MatrixBase<Derived> &observation, double weight = 1)
+  {
+    if (!weight)
+      return;
+
+    _weight += weight;
+    const Vector delta = observation.transpose() - _mean;
+    _mean += (weight / _weight) * delta;
+    _comoment.noalias() += weight * delta * (observation.transpose() - _mean).transpose();
+  }
+
+  void merge(const Moments &other)
+  {
+    if (!other._weight)
+      return;
+
+    const double weight = _weight + other._weight;
+
+    const Vector delta = other._mean - _mean;
+    _mean += (other._weight / weight) * delta;
+    _comoment += other._comoment + (_weight * other._weight / weight) * delta * delta.transpose();
+    _weight = weight;
+  }
+
+  // Restore from serialized state
+  void assign(double weight, const Vector &mean, const Matrix &comoment)
+  {
+    _weight = weight;
+    _mean = mean;
+    _comoment = comoment;
+  }
+
+  Matrix covariance() const { return _comoment / (_weight - 1); }
+
+  Matrix correlation() const
+  {
+    const Vector scale = _comoment.diagonal().array().rsqrt();
+    return scale.asDiagonal() * _comoment * scale.asDiagonal();
+  }
+
+  // Simple regressions of column 0 on each other column
+  //
+  // Column i holds the intercept and the slope against variable i.  Column 0
+  // holds the mean as the intercept of the empty model.
+  Eigen::Matrix<double, 2, N> regress() const
+  {
+    Eigen::Matrix<double, 2, N> beta(2, size());
+    beta.col(0) << _mean(0), 0;
+
+    for (Eigen::Index i = 1; i < size(); ++i) {
+      const double slope = _comoment(0, i) / _comoment(i, i);
+      beta.col(i) << _mean(0) - slope * _mean(i), slope;
+    }
+
+    return beta;
+  }
+
+  // Multiple least squares of column 0 on all other columns
+  //
+  // Return the intercept followed by the coefficients.
+  Vector fit() const
+  {
+    const Eigen::Index n = size() - 1;
+    Vector beta(size());
+
+    beta.tail(n) = _comoment.bottomRightCorner(n, n).ldlt().solve(_comoment.col(0).tail(n));
+    beta(0) = _mean(0) - _mean.tail(n).dot(beta.tail(n));
+    return beta;
+  }
+};
+
+} // namespace Bridge
+
+#endif
@@ -0,0 +1,60 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BRIDGE_SYMMETRY_HPP
+#define BRIDGE_SYMMETRY_HPP
+
+#include "DDS.hpp"
+#include <array>
+#include <utility>
+
+namespace Bridge {
+
+// Relabelling of suits followed by a clockwise rotation of seats
+//
+// Double-dummy tables commute with symmetries: the table of a transformed
+// deal is the transformed table.
+struct Symmetry
+{
+  // Image of each suit, indexed by Strain
+  std::array<Strain, 4> suits = { Strain::C, Strain::D, Strain::H, Strain::S };
+
+  // Seat s moves to (s + rotation) % 4
+  int rotation = 0;
+};
+
+Symmetry inverse(const Symmetry &);
+Deal transform(const Deal &, const Symmetry &);
+Result transform(const Result &, const Symmetry &);
+
+// Canonical representative of a deal under symmetries
+//
+// Only suit permutations preserving the mask are considered, so the canonical
+// deal can be solved with the same mask.  Return the canonical deal along
+// with the symmetry mapping the given deal to it.
+std::pair<Deal, Symmetry> canonicalize(const Deal &deal, StrainMask mask = {});
+
+// Solve each distinct canonical deal once
+//
+// This saves solver work on batches of constrained or enumerated deals, where
+// symmetric deals are common.
+std::vector<Result> solveCanonical(std::span<const Deal> deals, StrainMask mask = {});
+std::vector<Result> solveCanonical(std::span<const Deal> deals, Cache &cache, StrainMask mask = {});
+
+} // namespace Bridge
+
+#endif
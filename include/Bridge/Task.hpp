@@ -0,0 +1,74 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BRIDGE_TASK_HPP
+#define BRIDGE_TASK_HPP
+
+#include "DDS.hpp"
+#include <memory>
+#include <thread>
+
+namespace Bridge {
+
+// Solve running in the background
+//
+// Results stream out pack by pack while later packs are being solved.  The
+// task can be cancelled between packs, and is cancelled when destroyed, so
+// abandoned requests stop wasting the solver.  A moved-from task acts as one
+// that has ended with no results.
+class Task
+{
+  struct State;
+  std::unique_ptr<State> _state;
+  std::jthread _thread;
+
+  static void run(std::stop_token, State &, const Source &, const Sink &, StrainMask, const Observer &);
+
+public:
+  // Solve deals, collecting results in order to be taken
+  explicit Task(std::vector<Deal> deals, StrainMask mask = {}, Observer observer = {});
+
+  // Solve a stream, where the sink is called from a worker thread as usual
+  Task(Source source, Sink sink, StrainMask mask = {}, Observer observer = {});
+
+  Task(Task &&) noexcept;
+  Task &operator=(Task &&) noexcept;
+  ~Task();
+
+  // Number of deals passed to the sink or collected so far
+  std::size_t progress() const;
+
+  // Whether the solve has ended, either completed or cancelled
+  bool done() const;
+
+  // Stop drawing deals.  The pack in DDS is discarded on completion.
+  void cancel();
+
+  // Block until the solve ends, rethrowing any error from it
+  void wait();
+
+  // Remove and return results collected so far
+  std::vector<Result> take();
+
+  // Block until results are collected, then take them.  Return an empty
+  // vector when the solve has ended.
+  std::vector<Result> next();
+};
+
+} // namespace Bridge
+
+#endif
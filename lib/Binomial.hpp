@@ -0,0 +1,48 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BRIDGE_BINOMIAL_HPP
+#define BRIDGE_BINOMIAL_HPP
+
+#include <array>
+#include <cstdint>
+
+namespace Bridge {
+
+// Binomial coefficients up to C(52, k), which fit in 64 bits
+inline constexpr auto binomials = []
+{
+  std::array<std::array<std::uint64_t, 53>, 53> values {};
+
+  for (int n = 0; n <= 52; ++n) {
+    values[n][0] = 1;
+
+    for (int k = 1; k <= n; ++k)
+      values[n][k] = values[n - 1][k - 1] + values[n - 1][k];
+  }
+
+  return values;
+}();
+
+inline std::uint64_t choose(int n, int k)
+{
+  return k < 0 || k > n ? 0 : binomials[n][k];
+}
+
+} // namespace Bridge
+
+#endif
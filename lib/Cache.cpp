@@ -0,0 +1,222 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Bridge/Cache.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+const char magic[8] = { 'B', 'r', 'i', 'd', 'g', 'e', 'D', 'D' };
+const std::uint64_t initialCapacity = 1 << 16;
+
+struct Header
+{
+  char magic[8];
+  std::uint64_t capacity;
+  std::uint64_t size;
+};
+
+struct Entry
+{
+  Bridge::PackedDeal key;
+
+  // Solved strains as bits in the order of Bridge::Strain, 0 if empty
+  std::uint8_t strains;
+
+  // Tricks of solved strains, zero elsewhere
+  Bridge::PackedResult tricks;
+};
+
+static_assert(sizeof(Entry) == 24);
+
+unsigned getStrains(Bridge::StrainMask mask)
+{
+  return (!mask.c) | (!mask.d) << 1 | (!mask.h) << 2 | (!mask.s) << 3 | (!mask.n) << 4;
+}
+
+std::uint64_t hash(const Bridge::PackedDeal &key)
+{
+  std::uint64_t low, high = 0;
+  std::memcpy(&low, key.data(), 8);
+  std::memcpy(&high, key.data() + 8, 5);
+
+  // SplitMix64 finalizer
+  std::uint64_t x = low ^ high * 0x9E3779B97F4A7C15;
+  x = (x ^ x >> 30) * 0xBF58476D1CE4E5B9;
+  x = (x ^ x >> 27) * 0x94D049BB133111EB;
+  return x ^ x >> 31;
+}
+
+} // namespace
+
+struct Bridge::Cache::Storage
+{
+  boost::interprocess::file_mapping file;
+  boost::interprocess::mapped_region region;
+
+  Header &getHeader() const
+  {
+    return *static_cast<Header *>(region.get_address());
+  }
+
+  Entry *getEntries() const
+  {
+    return reinterpret_cast<Entry *>(static_cast<char *>(region.get_address()) + sizeof(Header));
+  }
+
+  // Slot of the key, or the empty slot where it would be inserted
+  Entry &probe(const PackedDeal &key) const
+  {
+    const std::uint64_t mask = getHeader().capacity - 1;
+    Entry *entries = getEntries();
+
+    for (std::uint64_t i = hash(key) & mask; ; i = (i + 1) & mask)
+      if (!entries[i].strains || entries[i].key == key)
+        return entries[i];
+  }
+};
+
+Bridge::Cache::Cache(std::string path, bool writable)
+  : _path(std::move(path)), _writable(writable)
+{
+  if (std::filesystem::exists(_path))
+    open();
+}
+
+Bridge::Cache::~Cache() = default;
+
+void Bridge::Cache::open()
+{
+  namespace ipc = boost::interprocess;
+  const ipc::mode_t mode = _writable ? ipc::read_write : ipc::read_only;
+
+  ipc::file_mapping file(_path.c_str(), mode);
+  ipc::mapped_region region(file, mode);
+  const auto *header = static_cast<const Header *>(region.get_address());
+
+  if (region.get_size() < sizeof(Header)
+      || std::memcmp(header->magic, magic, sizeof(magic))
+      || region.get_size() != sizeof(Header) + header->capacity * sizeof(Entry))
+    throw std::runtime_error("Bridge::Cache: invalid cache file " + _path);
+
+  _storage.reset(new Storage { std::move(file), std::move(region) });
+}
+
+// Rehash into a file of twice the capacity, which then replaces the old one
+void Bridge::Cache::grow()
+{
+  namespace ipc = boost::interprocess;
+
+  const std::uint64_t capacity = _storage ? 2 * _storage->getHeader().capacity : initialCapacity;
+  const std::string temporary = _path + ".tmp";
+
+  if (!std::ofstream(temporary, std::ios::binary | std::ios::trunc))
+    throw std::runtime_error("Bridge::Cache: cannot create " + temporary);
+
+  std::filesystem::resize_file(temporary, sizeof(Header) + capacity * sizeof(Entry));
+
+  {
+    ipc::file_mapping file(temporary.c_str(), ipc::read_write);
+    ipc::mapped_region region(file, ipc::read_write);
+    Storage next { std::move(file), std::move(region) };
+    Header &header = next.getHeader();
+
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.capacity = capacity;
+    header.size = 0;
+
+    if (_storage) {
+      const Entry *entries = _storage->getEntries();
+
+      for (std::uint64_t i = 0; i < _storage->getHeader().capacity; ++i)
+        if (entries[i].strains)
+          next.probe(entries[i].key) = entries[i];
+
+      header.size = _storage->getHeader().size;
+    }
+
+    next.region.flush();
+  }
+
+  _storage.reset();
+  std::filesystem::rename(temporary, _path);
+  open();
+}
+
+std::size_t Bridge::Cache::size() const
+{
+  return _storage ? _storage->getHeader().size : 0;
+}
+
+std::optional<Bridge::Result> Bridge::Cache::find(const Bridge::Deal &deal, Bridge::StrainMask mask) const
+{
+  if (!_storage)
+    return std::nullopt;
+
+  const Entry &entry = _storage->probe(pack(deal));
+  const unsigned strains = getStrains(mask);
+
+  if ((entry.strains & strains) != strains)
+    return std::nullopt;
+
+  Result result = unpack(entry.tricks);
+
+  // Hide strains solved for other masks
+  for (int strain = 0; strain < 5; ++strain)
+    if (!(strains >> strain & 1))
+      for (int seat = 0; seat < 4; ++seat)
+        result.set(Strain(strain), Seat(seat), 0);
+
+  return result;
+}
+
+void Bridge::Cache::insert(const Bridge::Deal &deal, const Bridge::Result &result, Bridge::StrainMask mask)
+{
+  const unsigned strains = getStrains(mask);
+
+  if (!_writable || !strains)
+    return;
+
+  if (!_storage || 2 * (_storage->getHeader().size + 1) > _storage->getHeader().capacity)
+    grow();
+
+  const PackedDeal key = pack(deal);
+  Entry &entry = _storage->probe(key);
+
+  if (!entry.strains) {
+    entry.key = key;
+    ++_storage->getHeader().size;
+  }
+
+  // Keep strains solved earlier for other masks
+  Result merged = unpack(entry.tricks);
+
+  for (int strain = 0; strain < 5; ++strain)
+    if (strains >> strain & 1)
+      for (int seat = 0; seat < 4; ++seat)
+        merged.set(Strain(strain), Seat(seat), result(Strain(strain), Seat(seat)));
+
+  entry.tricks = pack(merged);
+
+  // Mark the slot occupied only after the payload is written
+  entry.strains |= strains;
+}
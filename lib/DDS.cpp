@@ -16,8 +16,17 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <Bridge/DDS.hpp>
+#include <Bridge/Cache.hpp>
 #include <dll.h>
 #include <algorithm>
+#include <bitset>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
 
 Bridge::Result::Result(const ::ddTableResults &table)
   : _strains {
@@ -54,7 +63,29 @@ Bridge::Result::Result(const ::ddTableResults &table)
   }
 {}
 
-static ::ddTableDeal convertToDDS(const Bridge::Deal &deal)
+Bridge::PackedResult Bridge::pack(const Bridge::Result &result)
+{
+  PackedResult packed = {};
+
+  for (int strain = 0; strain < 5; ++strain)
+    for (int seat = 0; seat < 4; ++seat)
+      packed[2 * strain + seat / 2] |= result(Strain(strain), Seat(seat)) << 4 * (seat % 2);
+
+  return packed;
+}
+
+Bridge::Result Bridge::unpack(const Bridge::PackedResult &packed)
+{
+  Result result;
+
+  for (int strain = 0; strain < 5; ++strain)
+    for (int seat = 0; seat < 4; ++seat)
+      result.set(Strain(strain), Seat(seat), packed[2 * strain + seat / 2] >> 4 * (seat % 2) & 15);
+
+  return result;
+}
+
+::ddTableDeal Bridge::convertToDDS(const Bridge::Deal &deal)
 {
   using namespace Bridge;
 
@@ -86,32 +117,516 @@ static ::ddTableDeal convertToDDS(const Bridge::Deal &deal)
   }};
 }
 
-std::vector<Bridge::Result> Bridge::solve(std::span<const Bridge::Deal> deals, Bridge::StrainMask mask)
+namespace {
+
+struct Pack
 {
-  const std::size_t strains = !mask.c + !mask.d + !mask.h + !mask.s + !mask.n;
-  const std::size_t packSize = MAXNOOFTABLES * DDS_STRAINS / strains;
-  const std::size_t q = deals.size() / packSize;
-  const std::size_t r = deals.size() % packSize;
+  std::vector<Bridge::Deal> deals;
+  std::vector<Bridge::Result> results;
+
+  // Indices of deals sent to DDS
+  std::vector<std::size_t> misses;
+
+  ::ddTableDeals tables;
+  ::ddTablesRes solutions;
+};
+
+} // namespace
 
+Bridge::SolveStats &Bridge::SolveStats::operator+=(const Bridge::PackStats &pack)
+{
+  ++packs;
+  deals += pack.deals;
+  solved += pack.solved;
+  capacity += pack.capacity;
+  tables += pack.solved * pack.strains;
+  wall += pack.wall;
+  solver += pack.solver;
+  stall += pack.stall;
+
+  if (pack.error != RETURN_NO_FAULT) {
+    ++failures;
+    error = pack.error;
+  }
+
+  return *this;
+}
+
+Bridge::SolveStats &Bridge::SolveStats::operator+=(const Bridge::SolveStats &other)
+{
+  packs += other.packs;
+  deals += other.deals;
+  solved += other.solved;
+  capacity += other.capacity;
+  tables += other.tables;
+  wall += other.wall;
+  solver += other.solver;
+  stall += other.stall;
+
+  if (other.failures) {
+    failures += other.failures;
+    error = other.error;
+  }
+
+  return *this;
+}
+
+std::ostream &Bridge::operator<<(std::ostream &stream, const Bridge::SolveStats &stats)
+{
+  using Seconds = std::chrono::duration<double>;
+  const double wall = Seconds(stats.wall).count();
+  const double solver = Seconds(stats.solver).count();
+
+  stream << "Packs: " << stats.packs
+    << "\nDeals: " << stats.deals << " drawn, " << stats.solved << " solved, "
+    << stats.tables << " strains\n"
+    << "Pack fill: " << 100.0 * stats.solved / std::max<std::size_t>(stats.capacity, 1) << "%\n"
+    << "Time: " << wall << " s, " << solver << " s in DDS, "
+    << wall - solver << " s overhead, " << Seconds(stats.stall).count() << " s stalled\n"
+    << "Rate: " << stats.solved / std::max(solver, 1e-9) << " deals/s in DDS\n";
+
+  if (stats.failures) {
+    char message[80];
+    ::ErrorMessage(stats.error, message);
+    stream << "Errors: " << stats.failures << " packs, last " << stats.error << ": " << message << '\n';
+  }
+
+  return stream;
+}
+
+void Bridge::setResources(int threads, int memory)
+{
+  ::SetResources(memory, threads);
+}
+
+// Solve deals from the source, where total is the number of deals if known
+static void pipeline(const Bridge::Source &source, const Bridge::Sink &sink,
+    Bridge::StrainMask mask, Bridge::Cache *cache, const Bridge::Observer &observer, std::size_t total = 0)
+{
+  using Clock = std::chrono::steady_clock;
+  const std::size_t strains = !mask.c + !mask.d + !mask.h + !mask.s + !mask.n;
+  const std::size_t capacity = MAXNOOFTABLES * DDS_STRAINS / strains;
   int filters[5] = { mask.s, mask.h, mask.d, mask.c, mask.n };
-  std::vector<Bridge::Result> results;
-  results.reserve(deals.size());
-
-  for (std::size_t i = 0; i < q; ++i) {
-    ::ddTablesRes res = {};
-    ::ddTableDeals pack = { static_cast<int>(packSize), {} };
-    std::transform(deals.begin() + i * packSize, deals.begin() + (i + 1) * packSize, pack.deals, convertToDDS);
-    ::CalcAllTables(&pack, -1, filters, &res, nullptr);
-    std::copy(res.results, res.results + packSize, std::back_inserter(results));
+
+  // Spread a known number of deals evenly over the fewest packs, so that
+  // DDS threads are not left idle on a nearly empty last pack
+  const std::size_t count = (total + capacity - 1) / capacity;
+  const std::size_t packSize = total ? (total + count - 1) / count : capacity;
+
+  // Bound memory when most deals are cache hits
+  const std::size_t maxDraw = 8 * capacity;
+  bool exhausted = false;
+
+  // Three packs rotate between the stages: one is being solved, one is being
+  // drawn from the source, and one is waiting for the sink.
+  const auto packs = std::make_unique<Pack[]>(3);
+  Pack *current = &packs[0];
+  Pack *next = &packs[1];
+  Pack *done = &packs[2];
+
+  const auto prepare = [&](Pack &pack)
+  {
+    pack.deals.clear();
+    pack.results.clear();
+    pack.misses.clear();
+
+    while (!exhausted && pack.misses.size() < packSize && pack.deals.size() < maxDraw) {
+      const std::size_t offset = pack.deals.size();
+      pack.deals.resize(offset + packSize - pack.misses.size());
+
+      const std::size_t count = source(std::span(pack.deals).subspan(offset));
+      pack.deals.resize(offset + count);
+      pack.results.resize(offset + count);
+      exhausted = !count;
+
+      for (std::size_t i = offset; i < pack.deals.size(); ++i) {
+        if (cache) {
+          if (const auto hit = cache->find(pack.deals[i], mask)) {
+            pack.results[i] = *hit;
+            continue;
+          }
+        }
+        pack.misses.push_back(i);
+      }
+    }
+
+    pack.tables.noOfTables = static_cast<int>(pack.misses.size());
+
+    for (std::size_t k = 0; k < pack.misses.size(); ++k)
+      pack.tables.deals[k] = convertToDDS(pack.deals[pack.misses[k]]);
+  };
+
+  const auto finish = [&](Pack &pack)
+  {
+    for (std::size_t k = 0; k < pack.misses.size(); ++k) {
+      const std::size_t i = pack.misses[k];
+      pack.results[i] = pack.solutions.results[k];
+
+      if (cache)
+        cache->insert(pack.deals[i], pack.results[i], mask);
+    }
+
+    sink(pack.deals, pack.results);
+  };
+
+  // One helper thread serves the whole stream.  It finishes the done pack
+  // and prepares the next one on request, while this thread waits for DDS.
+  std::mutex mutex;
+  std::condition_variable_any changed;
+  bool requested = false;
+  bool pending = false;
+  std::exception_ptr error;
+
+  std::jthread helper([&](std::stop_token stop)
+  {
+    std::unique_lock lock(mutex);
+
+    while (changed.wait(lock, stop, [&] { return requested; })) {
+      lock.unlock();
+
+      try {
+        if (pending)
+          finish(*done);
+        prepare(*next);
+      }
+      catch (...) {
+        error = std::current_exception();
+      }
+
+      lock.lock();
+      requested = false;
+      changed.notify_all();
+    }
+  });
+
+  auto start = Clock::now();
+  prepare(*current);
+
+  while (!current->deals.empty()) {
+    std::unique_lock lock(mutex);
+    requested = true;
+    lock.unlock();
+    changed.notify_all();
+
+    Bridge::PackStats stats;
+    stats.deals = current->deals.size();
+    stats.solved = current->misses.size();
+    stats.capacity = capacity;
+    stats.strains = strains;
+
+    current->solutions = {};
+    const auto solving = Clock::now();
+
+    if (current->tables.noOfTables)
+      stats.error = ::CalcAllTables(&current->tables, -1, filters, &current->solutions, nullptr);
+
+    const auto solved = Clock::now();
+    lock.lock();
+    changed.wait(lock, [&] { return !requested; });
+    lock.unlock();
+
+    if (error)
+      std::rethrow_exception(error);
+
+    // Nothing is left to overlap with the last pack
+    if (next->deals.empty())
+      finish(*current);
+
+    const auto stop = Clock::now();
+    stats.wall = stop - start;
+    stats.solver = solved - solving;
+    stats.stall = stop - solved;
+    start = stop;
+
+    if (observer)
+      observer(stats);
+
+    pending = true;
+    std::swap(done, current);
+    std::swap(current, next);
+  }
+}
+
+// Order deals so that those sharing holdings are adjacent
+//
+// Columns of holdings with fewer distinct values, such as those of known
+// hands, lead the sort key.  Completions of the same partial deal then land
+// in the same packs, where DDS reuses its search state across similar deals.
+static std::vector<std::size_t> getLocalOrder(std::span<const Bridge::Deal> deals)
+{
+  using Key = std::array<std::uint16_t, 16>;
+  std::array<int, 16> columns;
+  std::array<std::size_t, 16> distinct;
+
+  for (int column = 0; column < 16; ++column) {
+    std::bitset<8192> seen;
+
+    for (const Bridge::Deal &deal : deals)
+      seen.set(deal[Bridge::Seat(column / 4)][Bridge::Strain(column % 4)].bits() >> 2);
+
+    columns[column] = column;
+    distinct[column] = seen.count();
   }
 
-  if (r) {
-    ::ddTablesRes res = {};
-    ::ddTableDeals pack = { static_cast<int>(r), {} };
-    std::transform(deals.begin() + q * packSize, deals.end(), pack.deals, convertToDDS);
-    ::CalcAllTables(&pack, -1, filters, &res, nullptr);
-    std::copy(res.results, res.results + r, std::back_inserter(results));
+  std::stable_sort(columns.begin(), columns.end(), [&distinct](int x, int y) { return distinct[x] < distinct[y]; });
+  std::vector<std::pair<Key, std::size_t>> keys(deals.size());
+
+  for (std::size_t i = 0; i < deals.size(); ++i) {
+    for (int k = 0; k < 16; ++k)
+      keys[i].first[k] = deals[i][Bridge::Seat(columns[k] / 4)][Bridge::Strain(columns[k] % 4)].bits();
+
+    keys[i].second = i;
   }
 
+  std::sort(keys.begin(), keys.end());
+  std::vector<std::size_t> order(deals.size());
+
+  for (std::size_t i = 0; i < deals.size(); ++i)
+    order[i] = keys[i].second;
+
+  return order;
+}
+
+static std::vector<Bridge::Result> collect(std::span<const Bridge::Deal> deals,
+    Bridge::StrainMask mask, Bridge::Cache *cache, const Bridge::Observer &observer, bool local = false)
+{
+  const std::vector<std::size_t> order = local ? getLocalOrder(deals) : std::vector<std::size_t>();
+  std::vector<Bridge::Result> results(deals.size());
+  std::size_t produced = 0;
+  std::size_t consumed = 0;
+
+  const auto source = [&](std::span<Bridge::Deal> buffer)
+  {
+    const std::size_t size = std::min(buffer.size(), deals.size() - produced);
+
+    for (std::size_t i = 0; i < size; ++i, ++produced)
+      buffer[i] = deals[local ? order[produced] : produced];
+
+    return size;
+  };
+
+  // Scatter results back to the order of the caller
+  const auto sink = [&](std::span<const Bridge::Deal>, std::span<const Bridge::Result> pack)
+  {
+    for (std::size_t i = 0; i < pack.size(); ++i, ++consumed)
+      results[local ? order[consumed] : consumed] = pack[i];
+  };
+
+  pipeline(source, sink, mask, cache, observer, deals.size());
   return results;
 }
+
+void Bridge::solve(const Source &source, const Sink &sink, Bridge::StrainMask mask, const Observer &observer)
+{
+  pipeline(source, sink, mask, nullptr, observer);
+}
+
+void Bridge::solve(const Source &source, const Sink &sink, Bridge::Cache &cache, Bridge::StrainMask mask, const Observer &observer)
+{
+  pipeline(source, sink, mask, &cache, observer);
+}
+
+std::vector<Bridge::Result> Bridge::solve(std::span<const Bridge::Deal> deals, Bridge::StrainMask mask, const Observer &observer)
+{
+  return collect(deals, mask, nullptr, observer);
+}
+
+std::vector<Bridge::Result> Bridge::solve(std::span<const Bridge::Deal> deals, Bridge::Cache &cache, Bridge::StrainMask mask, const Observer &observer)
+{
+  return collect(deals, mask, &cache, observer);
+}
+
+std::vector<Bridge::Result> Bridge::solveClustered(std::span<const Bridge::Deal> deals, Bridge::StrainMask mask, const Observer &observer)
+{
+  return collect(deals, mask, nullptr, observer, true);
+}
+
+std::vector<Bridge::Result> Bridge::solveClustered(std::span<const Bridge::Deal> deals, Bridge::Cache &cache, Bridge::StrainMask mask, const Observer &observer)
+{
+  return collect(deals, mask, &cache, observer, true);
+}
+
+// Relative costs of solving a strain as a table and a single contract, in
+// units of a full single-contract search
+static const double tableCost = 2.0;
+static const double contractCost = 1.0;
+static const double targetCost = 0.6;
+
+static ::deal convertToBoard(const Bridge::Query &query)
+{
+  const int trumps[] = { 3, 2, 1, 0, 4 };
+  const ::ddTableDeal table = convertToDDS(query.deal);
+  ::deal board = {};
+
+  board.trump = trumps[static_cast<int>(query.strain)];
+  board.first = (static_cast<int>(query.declarer) + 1) % 4;
+  std::copy(&table.cards[0][0], &table.cards[0][0] + DDS_HANDS * DDS_SUITS, &board.remainCards[0][0]);
+  return board;
+}
+
+// Throw the message of a DDS error code
+static void check(int error)
+{
+  if (error != RETURN_NO_FAULT) {
+    char message[80];
+    ::ErrorMessage(error, message);
+    throw std::runtime_error(message);
+  }
+}
+
+static std::vector<int> solveBoards(std::span<const Bridge::Query> queries)
+{
+  std::vector<int> answers;
+  answers.reserve(queries.size());
+
+  const auto boards = std::make_unique<::boards>();
+  const auto solved = std::make_unique<::solvedBoards>();
+
+  for (std::size_t offset = 0; offset < queries.size(); offset += MAXNOOFBOARDS) {
+    const std::size_t size = std::min<std::size_t>(MAXNOOFBOARDS, queries.size() - offset);
+    boards->noOfBoards = static_cast<int>(size);
+
+    for (std::size_t i = 0; i < size; ++i) {
+      const Bridge::Query &query = queries[offset + i];
+      boards->deals[i] = convertToBoard(query);
+
+      // Defenders lead, so the target is the number of tricks to defeat
+      boards->target[i] = query.target < 0 ? -1 : 14 - query.target;
+      boards->solutions[i] = 1;
+      boards->mode[i] = 1;
+    }
+
+    *solved = {};
+    check(::SolveAllBoardsBin(boards.get(), solved.get()));
+
+    for (std::size_t i = 0; i < size; ++i) {
+      const int score = solved->solvedBoard[i].score[0];
+      answers.push_back(queries[offset + i].target < 0 ? 13 - score : score < boards->target[i]);
+    }
+  }
+
+  return answers;
+}
+
+std::vector<Bridge::Leads> Bridge::solveLeads(std::span<const Bridge::Query> queries)
+{
+  std::vector<Leads> leads(queries.size());
+
+  const auto boards = std::make_unique<::boards>();
+  const auto solved = std::make_unique<::solvedBoards>();
+
+  for (std::size_t offset = 0; offset < queries.size(); offset += MAXNOOFBOARDS) {
+    const std::size_t size = std::min<std::size_t>(MAXNOOFBOARDS, queries.size() - offset);
+    boards->noOfBoards = static_cast<int>(size);
+
+    // Ask for every legal card, which are all the cards of the leader
+    for (std::size_t i = 0; i < size; ++i) {
+      boards->deals[i] = convertToBoard(queries[offset + i]);
+      boards->target[i] = -1;
+      boards->solutions[i] = 3;
+      boards->mode[i] = 1;
+    }
+
+    *solved = {};
+    check(::SolveAllBoardsBin(boards.get(), solved.get()));
+
+    // DDS lists one card of each run of equivalent cards, and scores are
+    // tricks for the defenders
+    for (std::size_t i = 0; i < size; ++i) {
+      const ::futureTricks &future = solved->solvedBoard[i];
+
+      for (int k = 0; k < future.cards; ++k) {
+        const Strain suit = Strain(3 - future.suit[k]);
+        const int tricks = 13 - future.score[k];
+        leads[offset + i].set(suit, future.rank[k], tricks);
+
+        for (int rank = 2; rank <= 14; ++rank)
+          if (future.equals[k] >> rank & 1)
+            leads[offset + i].set(suit, rank, tricks);
+      }
+    }
+  }
+
+  return leads;
+}
+
+std::vector<int> Bridge::solve(std::span<const Bridge::Query> queries)
+{
+  std::vector<int> answers(queries.size());
+
+  // Group queries by deal
+  std::vector<std::pair<PackedDeal, std::size_t>> keys;
+  keys.reserve(queries.size());
+
+  for (std::size_t i = 0; i < queries.size(); ++i) {
+    const int target = queries[i].target;
+
+    // Trivial targets need no search
+    if (target == 0 || target > 13)
+      answers[i] = target == 0;
+    else
+      keys.emplace_back(pack(queries[i].deal), i);
+  }
+
+  std::sort(keys.begin(), keys.end());
+
+  // Table deals grouped by the strains to solve
+  std::vector<Deal> tables[32];
+  std::vector<std::vector<std::size_t>> tableQueries[32];
+  std::vector<Query> boards;
+  std::vector<std::size_t> boardQueries;
+
+  for (auto begin = keys.begin(); begin != keys.end();) {
+    const auto end = std::find_if(begin, keys.end(), [begin](const auto &key) { return key.first != begin->first; });
+    unsigned strains = 0;
+    double boardCost = 0;
+
+    for (auto key = begin; key != end; ++key) {
+      const Query &query = queries[key->second];
+      strains |= 1u << static_cast<int>(query.strain);
+      boardCost += query.target < 0 ? contractCost : targetCost;
+    }
+
+    if (tableCost * __builtin_popcount(strains) < boardCost) {
+      tables[strains].push_back(queries[begin->second].deal);
+      tableQueries[strains].emplace_back();
+
+      for (auto key = begin; key != end; ++key)
+        tableQueries[strains].back().push_back(key->second);
+    }
+    else {
+      for (auto key = begin; key != end; ++key) {
+        boards.push_back(queries[key->second]);
+        boardQueries.push_back(key->second);
+      }
+    }
+
+    begin = end;
+  }
+
+  for (unsigned strains = 1; strains < 32; ++strains) {
+    if (tables[strains].empty())
+      continue;
+
+    const StrainMask mask = {
+      !(strains & 1), !(strains >> 1 & 1), !(strains >> 2 & 1), !(strains >> 3 & 1), !(strains >> 4 & 1),
+    };
+
+    const std::vector<Result> results = solve(tables[strains], mask, [](const PackStats &stats) { check(stats.error); });
+
+    for (std::size_t k = 0; k < results.size(); ++k) {
+      for (const std::size_t i : tableQueries[strains][k]) {
+        const Query &query = queries[i];
+        const int tricks = results[k](query.strain, query.declarer);
+        answers[i] = query.target < 0 ? tricks : tricks >= query.target;
+      }
+    }
+  }
+
+  const std::vector<int> solved = solveBoards(boards);
+
+  for (std::size_t k = 0; k < solved.size(); ++k)
+    answers[boardQueries[k]] = solved[k];
+
+  return answers;
+}
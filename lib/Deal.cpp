@@ -15,14 +15,136 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
-#include <Bridge/Deal.hpp>
+#include "Binomial.hpp"
+#include "Parallel.hpp"
+#include <Bridge/Random.hpp>
 #include <boost/container/small_vector.hpp>
 #include <algorithm>
+#include <numeric>
 #include <random>
+#include <stdexcept>
 
-static std::mt19937 generator(std::random_device{}());
+static Bridge::Philox &getLocalGenerator()
+{
+  static thread_local Bridge::Philox generator = []
+  {
+    std::random_device device;
+    return Bridge::Philox(static_cast<std::uint64_t>(device()) << 32 | device());
+  }();
+
+  return generator;
+}
+
+Bridge::PackedDeal Bridge::pack(const Bridge::Deal &deal)
+{
+  PackedDeal packed = {};
+
+  for (int seat = 0; seat < 4; ++seat) {
+    for (int suit = 0; suit < 4; ++suit) {
+      for (unsigned bits = deal[Seat(seat)][Strain(suit)].bits() >> 2; bits; bits &= bits - 1) {
+        const int card = 13 * suit + __builtin_ctz(bits);
+        packed[card / 4] |= seat << 2 * (card % 4);
+      }
+    }
+  }
+
+  return packed;
+}
+
+Bridge::Deal Bridge::unpack(const Bridge::PackedDeal &packed)
+{
+  Deal deal = {};
+
+  for (int card = 0; card < 52; ++card)
+    deal[Seat(packed[card / 4] >> 2 * (card % 4) & 3)].set({ Strain(card / 13), card % 13 + 2 });
+
+  return deal;
+}
+
+Bridge::DealIndex Bridge::getIndex(const Bridge::Deal &deal)
+{
+  const PackedDeal packed = pack(deal);
+  int pool[52];
+  int left = 52;
+  DealIndex index = 0;
+  DealIndex radix = 1;
+
+  std::iota(pool, pool + 52, 0);
+
+  for (int seat = 0; seat < 3; ++seat) {
+    std::uint64_t rank = 0;
+    int rest = 0;
+    int k = 0;
+
+    for (int c = 0; c < left; ++c) {
+      const int card = pool[c];
+
+      if ((packed[card / 4] >> 2 * (card % 4) & 3) == seat)
+        rank += choose(c, ++k);
+      else
+        pool[rest++] = card;
+    }
+
+    index += rank * radix;
+    radix *= choose(left, 13);
+    left = rest;
+  }
+
+  return index;
+}
+
+Bridge::Deal Bridge::getDeal(Bridge::DealIndex index)
+{
+  const DealIndex size = DealIndex(choose(52, 13)) * choose(39, 13) * choose(26, 13);
+
+  if (index >= size)
+    throw std::out_of_range("Bridge::getDeal: index out of range");
+
+  int pool[52];
+  int left = 52;
+  Deal deal;
+
+  std::iota(pool, pool + 52, 0);
+
+  for (int seat = 0; seat < 3; ++seat) {
+    const std::uint64_t combinations = choose(left, 13);
+    std::uint64_t rank = index % combinations;
+    bool chosen[52] = {};
+
+    index /= combinations;
+
+    for (int k = 13, c = left - 1; k > 0; --k, --c) {
+      while (choose(c, k) > rank)
+        --c;
+
+      rank -= choose(c, k);
+      chosen[c] = true;
+    }
+
+    int rest = 0;
+
+    for (int c = 0; c < left; ++c) {
+      if (chosen[c])
+        deal[Seat(seat)].set({ Strain(pool[c] / 13), pool[c] % 13 + 2 });
+      else
+        pool[rest++] = pool[c];
+    }
+
+    left = rest;
+  }
+
+  for (int c = 0; c < left; ++c)
+    deal[Seat::W].set({ Strain(pool[c] / 13), pool[c] % 13 + 2 });
+
+  return deal;
+}
 
 Bridge::Deal Bridge::getRandomDeal()
+{
+  return getRandomDeal(getLocalGenerator());
+}
+
+Bridge::Deal Bridge::getRandomDeal(Philox &generator)
 {
   Card deck[] = {
     { Strain::S,  2 }, { Strain::H,  2 }, { Strain::D,  2 }, { Strain::C,  2 },
@@ -40,7 +162,7 @@ Bridge::Deal Bridge::getRandomDeal()
     { Strain::S, 14 }, { Strain::H, 14 }, { Strain::D, 14 }, { Strain::C, 14 },
   };
 
-  std::shuffle(std::begin(deck), std::end(deck), generator);
+  shuffle(std::begin(deck), std::end(deck), generator);
   Deal deal = {};
 
   for (int seat = 0; seat < 4; ++seat)
@@ -59,6 +181,11 @@ static auto combine(const Bridge::Deal &deal, Bridge::Strain strain)
 }
 
 void Bridge::fillRandomCards(Bridge::Deal &deal)
+{
+  fillRandomCards(deal, getLocalGenerator());
+}
+
+void Bridge::fillRandomCards(Bridge::Deal &deal, Philox &generator)
 {
   const auto c = combine(deal, Strain::C);
   const auto d = combine(deal, Strain::D);
@@ -78,7 +205,7 @@ void Bridge::fillRandomCards(Bridge::Deal &deal)
       deck.emplace_back(Strain::S, rank);
   }
 
-  std::shuffle(deck.begin(), deck.end(), generator);
+  shuffle(deck.begin(), deck.end(), generator);
   auto take = deck.cbegin();
 
   for (auto slots = 13 - deal[Bridge::Seat::N].size(); slots--;)
@@ -93,3 +220,21 @@ void Bridge::fillRandomCards(Bridge::Deal &deal)
   for (auto slots = 13 - deal[Bridge::Seat::W].size(); slots--;)
     deal[Bridge::Seat::W].set(*take++);
 }
+
+void Bridge::getRandomDeals(std::span<Bridge::Deal> deals, std::uint64_t seed, std::uint64_t first)
+{
+  parallelFor(deals.size(), [=](std::size_t i)
+  {
+    Philox generator(seed, first + i);
+    deals[i] = getRandomDeal(generator);
+  });
+}
+
+void Bridge::fillRandomCards(std::span<Bridge::Deal> deals, std::uint64_t seed, std::uint64_t first)
+{
+  parallelFor(deals.size(), [=](std::size_t i)
+  {
+    Philox generator(seed, first + i);
+    fillRandomCards(deals[i], generator);
+  });
+}
@@ -0,0 +1,175 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Bridge/DealBatch.hpp>
+
+// Branchless popcount, which vectorizes unlike __builtin_popcount
+static std::uint16_t countBits(std::uint16_t x)
+{
+  x = x - (x >> 1 & 0x5555);
+  x = (x & 0x3333) + (x >> 2 & 0x3333);
+  x = (x + (x >> 4)) & 0x0F0F;
+  return (x + (x >> 8)) & 0x1F;
+}
+
+Bridge::DealBatch::DealBatch(std::span<const Bridge::Deal> deals)
+{
+  for (auto &column : _columns)
+    column.resize(deals.size());
+
+  for (std::size_t i = 0; i < deals.size(); ++i)
+    set(i, deals[i]);
+}
+
+void Bridge::DealBatch::clear()
+{
+  for (auto &column : _columns)
+    column.clear();
+}
+
+void Bridge::DealBatch::reserve(std::size_t capacity)
+{
+  for (auto &column : _columns)
+    column.reserve(capacity);
+}
+
+void Bridge::DealBatch::push_back(const Bridge::Deal &deal)
+{
+  for (int seat = 0; seat < 4; ++seat)
+    for (int suit = 0; suit < 4; ++suit)
+      _columns[4 * seat + suit].push_back(deal[Seat(seat)][Strain(suit)].bits());
+}
+
+Bridge::Deal Bridge::DealBatch::operator[](std::size_t i) const
+{
+  Deal deal;
+
+  for (int seat = 0; seat < 4; ++seat)
+    for (int suit = 0; suit < 4; ++suit)
+      deal[Seat(seat)][Strain(suit)] = Holding(_columns[4 * seat + suit][i]);
+
+  return deal;
+}
+
+void Bridge::DealBatch::set(std::size_t i, const Bridge::Deal &deal)
+{
+  for (int seat = 0; seat < 4; ++seat)
+    for (int suit = 0; suit < 4; ++suit)
+      _columns[4 * seat + suit][i] = deal[Seat(seat)][Strain(suit)].bits();
+}
+
+void Bridge::DealBatch::getLengths(Bridge::Seat seat, Bridge::Strain suit, std::span<std::uint8_t> lengths) const
+{
+  const std::uint16_t *holdings = column(seat, suit).data();
+
+  for (std::size_t i = 0; i < size(); ++i)
+    lengths[i] = countBits(holdings[i]);
+}
+
+void Bridge::DealBatch::getShapes(Bridge::Seat seat, std::span<std::uint16_t> shapes) const
+{
+  const std::uint16_t *c = column(seat, Strain::C).data();
+  const std::uint16_t *d = column(seat, Strain::D).data();
+  const std::uint16_t *h = column(seat, Strain::H).data();
+  const std::uint16_t *s = column(seat, Strain::S).data();
+
+  for (std::size_t i = 0; i < size(); ++i)
+    shapes[i] = countBits(c[i]) | countBits(d[i]) << 4 | countBits(h[i]) << 8 | countBits(s[i]) << 12;
+}
+
+void Bridge::DealBatch::getShapeClasses(Bridge::Seat seat, std::span<Bridge::ShapeClass> classes) const
+{
+  const std::uint16_t *suits[] = {
+    column(seat, Strain::C).data(),
+    column(seat, Strain::D).data(),
+    column(seat, Strain::H).data(),
+    column(seat, Strain::S).data(),
+  };
+
+  for (std::size_t i = 0; i < size(); ++i) {
+    int shortest = 13;
+    int longest = 0;
+    int doubletons = 0;
+
+    for (const std::uint16_t *suit : suits) {
+      const int length = countBits(suit[i]);
+      shortest = std::min(shortest, length);
+      longest = std::max(longest, length);
+      doubletons += length == 2;
+    }
+
+    // 4333, 4432, 5332 are balanced; 5422, 6322 are semi-balanced
+    classes[i] = shortest < 2 ? ShapeClass::Unbalanced
+      : longest <= 5 && doubletons <= 1 ? ShapeClass::Balanced
+      : longest <= 6 ? ShapeClass::SemiBalanced
+      : ShapeClass::Unbalanced;
+  }
+}
+
+void Bridge::DealBatch::getHCP(Bridge::Seat seat, std::span<int> points) const
+{
+  std::fill(points.begin(), points.end(), 0);
+
+  for (int suit = 0; suit < 4; ++suit) {
+    const std::uint16_t *holdings = column(seat, Strain(suit)).data();
+
+    for (std::size_t i = 0; i < size(); ++i) {
+      const unsigned x = holdings[i];
+      points[i] += 4 * (x >> 14 & 1) + 3 * (x >> 13 & 1) + 2 * (x >> 12 & 1) + (x >> 11 & 1);
+    }
+  }
+}
+
+void Bridge::DealBatch::getControls(Bridge::Seat seat, std::span<int> controls) const
+{
+  std::fill(controls.begin(), controls.end(), 0);
+
+  for (int suit = 0; suit < 4; ++suit) {
+    const std::uint16_t *holdings = column(seat, Strain(suit)).data();
+
+    for (std::size_t i = 0; i < size(); ++i) {
+      const unsigned x = holdings[i];
+      controls[i] += 2 * (x >> 14 & 1) + (x >> 13 & 1);
+    }
+  }
+}
+
+std::vector<Bridge::Result> Bridge::solve(const Bridge::DealBatch &deals, Bridge::StrainMask mask)
+{
+  std::vector<Result> results;
+  results.reserve(deals.size());
+  std::size_t offset = 0;
+
+  const auto source = [&](std::span<Deal> buffer)
+  {
+    const std::size_t size = std::min(buffer.size(), deals.size() - offset);
+
+    for (std::size_t i = 0; i < size; ++i)
+      buffer[i] = deals[offset + i];
+
+    offset += size;
+    return size;
+  };
+
+  const auto sink = [&results](std::span<const Deal>, std::span<const Result> pack)
+  {
+    results.insert(results.end(), pack.begin(), pack.end());
+  };
+
+  solve(source, sink, mask);
+  return results;
+}
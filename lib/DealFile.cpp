@@ -0,0 +1,166 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Bridge/DealFile.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace {
+
+const char magic[8] = { 'B', 'r', 'i', 'd', 'g', 'e', 'D', 'L' };
+
+struct Header
+{
+  char magic[8];
+  std::uint32_t stride;
+  std::uint32_t flags;
+};
+
+static_assert(sizeof(Header) == 16);
+
+} // namespace
+
+Bridge::DealWriter::DealWriter(std::string path, bool results)
+  : _stream(path, std::ios::binary | std::ios::trunc), _path(std::move(path)), _results(results)
+{
+  Header header = {};
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.stride = sizeof(PackedDeal) + results * sizeof(PackedResult);
+
+  if (!_stream.write(reinterpret_cast<const char *>(&header), sizeof(header)))
+    throw std::runtime_error("Bridge::DealWriter: cannot write " + _path);
+}
+
+void Bridge::DealWriter::write(const Deal &deal)
+{
+  if (_results)
+    throw std::logic_error("Bridge::DealWriter: missing result for " + _path);
+
+  const PackedDeal packed = pack(deal);
+  _stream.write(reinterpret_cast<const char *>(packed.data()), packed.size());
+}
+
+void Bridge::DealWriter::write(const Deal &deal, const Result &result)
+{
+  if (!_results)
+    throw std::logic_error("Bridge::DealWriter: no room for results in " + _path);
+
+  const PackedDeal packedDeal = pack(deal);
+  _stream.write(reinterpret_cast<const char *>(packedDeal.data()), packedDeal.size());
+
+  const PackedResult packedResult = pack(result);
+  _stream.write(reinterpret_cast<const char *>(packedResult.data()), packedResult.size());
+}
+
+void Bridge::DealWriter::write(std::span<const Deal> deals, std::span<const Result> results)
+{
+  if (!results.empty() && results.size() != deals.size())
+    throw std::invalid_argument("Bridge::DealWriter: got " + std::to_string(results.size())
+      + " results for " + std::to_string(deals.size()) + " deals");
+
+  for (std::size_t i = 0; i < deals.size(); ++i) {
+    if (results.empty())
+      write(deals[i]);
+    else
+      write(deals[i], results[i]);
+  }
+}
+
+void Bridge::DealWriter::flush()
+{
+  if (!_stream.flush())
+    throw std::runtime_error("Bridge::DealWriter: cannot write " + _path);
+}
+
+struct Bridge::DealFile::Storage
+{
+  boost::interprocess::file_mapping file;
+  boost::interprocess::mapped_region region;
+};
+
+Bridge::DealFile::DealFile(const std::string &path)
+{
+  namespace ipc = boost::interprocess;
+
+  if (std::filesystem::file_size(path) < sizeof(Header))
+    throw std::runtime_error("Bridge::DealFile: invalid deal file " + path);
+
+  ipc::file_mapping file(path.c_str(), ipc::read_only);
+  ipc::mapped_region region(file, ipc::read_only);
+  const auto *header = static_cast<const Header *>(region.get_address());
+
+  if (std::memcmp(header->magic, magic, sizeof(magic))
+      || (header->stride != sizeof(PackedDeal) && header->stride != sizeof(PackedDeal) + sizeof(PackedResult)))
+    throw std::runtime_error("Bridge::DealFile: invalid deal file " + path);
+
+  region.advise(ipc::mapped_region::advice_sequential);
+
+  _records = static_cast<const std::uint8_t *>(region.get_address()) + sizeof(Header);
+  _size = (region.get_size() - sizeof(Header)) / header->stride;
+  _stride = header->stride;
+  _storage.reset(new Storage { std::move(file), std::move(region) });
+}
+
+Bridge::DealFile::~DealFile() = default;
+
+Bridge::Deal Bridge::DealFile::operator[](std::size_t i) const
+{
+  PackedDeal packed;
+  std::memcpy(packed.data(), _records + i * _stride, packed.size());
+  return unpack(packed);
+}
+
+Bridge::Result Bridge::DealFile::result(std::size_t i) const
+{
+  PackedResult packed;
+  std::memcpy(packed.data(), _records + i * _stride + sizeof(PackedDeal), packed.size());
+  return unpack(packed);
+}
+
+Bridge::Source Bridge::DealFile::source(std::size_t first, std::size_t last) const
+{
+  last = std::min(last, _size);
+  first = std::min(first, last);
+
+  return [this, first, last](std::span<Deal> buffer) mutable
+  {
+    const std::size_t size = std::min(buffer.size(), last - first);
+
+    for (std::size_t i = 0; i < size; ++i)
+      buffer[i] = (*this)[first + i];
+
+    first += size;
+    return size;
+  };
+}
+
+Bridge::DealReader::DealReader(const std::string &path)
+{
+  if (std::filesystem::path(path).extension() == ".bin")
+    _binary = std::make_unique<DealFile>(path);
+  else
+    _text = std::make_unique<DealText>(path);
+}
+
+Bridge::Source Bridge::DealReader::source(std::size_t first, std::size_t last) const
+{
+  return _binary ? _binary->source(first, last) : _text->source(first, last);
+}
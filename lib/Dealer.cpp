@@ -0,0 +1,273 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Parallel.hpp"
+#include <Bridge/Dealer.hpp>
+#include <Bridge/Evaluator.hpp>
+#include <Bridge/Random.hpp>
+#include <boost/container/small_vector.hpp>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+static constexpr double factorials[14] = {
+  1, 1, 2, 6, 24, 120, 720, 5040, 40320, 362880, 3628800,
+  39916800, 479001600, 6227020800,
+};
+
+static const Bridge::Table hcpTable(Bridge::HCP);
+
+// Draws per deal before giving up on constraints that are never met
+static const std::size_t maxAttempts = 1 << 24;
+
+// Bounds of HCP in a suit of the given length
+static constexpr int maxHCP[14] = { 0, 4, 7, 9, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10 };
+static constexpr int minHCP[14] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 3, 6, 10 };
+
+Bridge::Shape Bridge::getShape(const Bridge::Hand &hand)
+{
+  return {
+    static_cast<int>(hand[Strain::C].size()),
+    static_cast<int>(hand[Strain::D].size()),
+    static_cast<int>(hand[Strain::H].size()),
+    static_cast<int>(hand[Strain::S].size()),
+  };
+}
+
+bool Bridge::isBalanced(const Bridge::Shape &shape)
+{
+  const auto [shortest, longest] = std::minmax_element(shape.begin(), shape.end());
+  return *shortest >= 2 && *longest <= 5 && std::count(shape.begin(), shape.end(), 2) <= 1;
+}
+
+namespace {
+
+// Depth-first search over the suit lengths of shaped seats
+class Enumeration
+{
+  const std::array<Bridge::Constraint, 4> &_constraints;
+  std::span<const Bridge::Seat> _seats;
+
+  std::array<unsigned char, 16> _lengths = {};
+  Bridge::Shape _remaining = { 13, 13, 13, 13 };
+
+  std::vector<std::array<unsigned char, 16>> &_layouts;
+  std::vector<double> &_weights;
+  std::size_t _limit;
+
+  bool checkShape(std::size_t k) const
+  {
+    using namespace Bridge;
+
+    const Constraint &constraint = _constraints[static_cast<int>(_seats[k])];
+    const Shape shape = { _lengths[4 * k], _lengths[4 * k + 1], _lengths[4 * k + 2], _lengths[4 * k + 3] };
+
+    const int least = minHCP[shape[0]] + minHCP[shape[1]] + minHCP[shape[2]] + minHCP[shape[3]];
+    const int most = maxHCP[shape[0]] + maxHCP[shape[1]] + maxHCP[shape[2]] + maxHCP[shape[3]];
+
+    // Also prune shapes that cannot meet the HCP requirement
+    return least <= constraint.hcp.max && most >= constraint.hcp.min
+      && (!constraint.shape || constraint.shape(shape));
+  }
+
+  // Number of deals with the current layout, up to a constant factor
+  double getWeight() const
+  {
+    double weight = 1;
+
+    for (int suit = 0; suit < 4; ++suit) {
+      weight /= factorials[_remaining[suit]];
+
+      for (std::size_t k = 0; k < _seats.size(); ++k)
+        weight /= factorials[_lengths[4 * k + suit]];
+    }
+
+    return weight;
+  }
+
+  void visit(std::size_t k, int suit, int slots)
+  {
+    if (overflows())
+      return;
+
+    if (suit == 4) {
+      if (!slots && checkShape(k))
+        visitSeat(k + 1);
+      return;
+    }
+
+    const Bridge::Range range = _constraints[static_cast<int>(_seats[k])].lengths[suit];
+    const int max = std::min({ range.max, slots, _remaining[suit] });
+
+    for (int length = std::max(range.min, 0); length <= max; ++length) {
+      _lengths[4 * k + suit] = length;
+      _remaining[suit] -= length;
+      visit(k, suit + 1, slots - length);
+      _remaining[suit] += length;
+    }
+  }
+
+  void visitSeat(std::size_t k)
+  {
+    if (k < _seats.size())
+      return visit(k, 0, 13);
+
+    if (overflows())
+      return;
+
+    _layouts.push_back(_lengths);
+    _weights.push_back(getWeight());
+  }
+
+public:
+  // Stop after the limit, which overflows() reports
+  Enumeration(
+      const std::array<Bridge::Constraint, 4> &constraints,
+      std::span<const Bridge::Seat> seats,
+      std::vector<std::array<unsigned char, 16>> &layouts,
+      std::vector<double> &weights,
+      std::size_t limit)
+    : _constraints(constraints), _seats(seats), _layouts(layouts), _weights(weights), _limit(limit)
+  {
+    visitSeat(0);
+  }
+
+  bool overflows() const { return _layouts.size() >= _limit; }
+};
+
+} // namespace
+
+Bridge::Dealer::Dealer(const std::array<Constraint, 4> &constraints, std::function<bool(const Deal &)> accept)
+  : _constraints(constraints), _accept(std::move(accept))
+{
+  for (int seat = 0; seat < 4; ++seat) {
+    const Constraint &constraint = _constraints[seat];
+    const bool free = !constraint.shape && std::all_of(constraint.lengths.begin(), constraint.lengths.end(),
+          [](Range range) { return range.min <= 0 && range.max >= 13; });
+
+    if (!free)
+      _shaped.push_back(Seat(seat));
+  }
+
+  // Mild constraints on all seats allow up to 560^4 layouts, so fall back to
+  // rejection sampling rather than storing them all
+  const std::size_t limit = 1 << 20;
+  std::vector<double> weights;
+
+  if (Enumeration(_constraints, _shaped, _layouts, weights, limit).overflows()) {
+    _layouts = {};
+    _probability = std::numeric_limits<double>::quiet_NaN();
+    return;
+  }
+
+  if (_layouts.empty())
+    throw std::invalid_argument("Bridge::Dealer: no deal satisfies the shape constraints");
+
+  _cumulative.reserve(weights.size());
+  std::partial_sum(weights.begin(), weights.end(), std::back_inserter(_cumulative));
+
+  // Deals of a layout = 13!^4 * weight * (13k)! / 13!^k for k free seats
+  const int free = 4 - _shaped.size();
+  _probability = std::exp(std::log(_cumulative.back()) + (8 - free) * std::lgamma(14.0)
+    + std::lgamma(13.0 * free + 1) - std::lgamma(53.0));
+}
+
+bool Bridge::Dealer::checkResidual(const Bridge::Deal &deal) const
+{
+  for (int seat = 0; seat < 4; ++seat) {
+    const Constraint &constraint = _constraints[seat];
+    const Hand &hand = deal[Seat(seat)];
+
+    if (!constraint.hcp.contains(apply(hcpTable, hand)) || (constraint.accept && !constraint.accept(hand)))
+      return false;
+  }
+
+  return !_accept || _accept(deal);
+}
+
+bool Bridge::Dealer::accepts(const Bridge::Deal &deal) const
+{
+  for (int seat = 0; seat < 4; ++seat) {
+    const Constraint &constraint = _constraints[seat];
+    const Shape shape = getShape(deal[Seat(seat)]);
+
+    for (int suit = 0; suit < 4; ++suit)
+      if (!constraint.lengths[suit].contains(shape[suit]))
+        return false;
+
+    if (constraint.shape && !constraint.shape(shape))
+      return false;
+  }
+
+  return checkResidual(deal);
+}
+
+Bridge::Deal Bridge::Dealer::operator()(Philox &generator) const
+{
+  if (_layouts.empty()) {
+    for (std::size_t attempt = 0; attempt < maxAttempts; ++attempt)
+      if (const Deal deal = getRandomDeal(generator); accepts(deal))
+        return deal;
+
+    throw std::runtime_error("Bridge::Dealer: no deal accepted after " + std::to_string(maxAttempts) + " draws");
+  }
+
+  for (std::size_t attempt = 0; attempt < maxAttempts; ++attempt) {
+    const double target = getCanonical(generator) * _cumulative.back();
+    const auto found = std::upper_bound(_cumulative.begin(), _cumulative.end(), target);
+    const auto &lengths = _layouts[std::min<std::size_t>(found - _cumulative.begin(), _layouts.size() - 1)];
+
+    Deal deal = {};
+    boost::container::small_vector<Card, 52> pool;
+
+    for (int suit = 0; suit < 4; ++suit) {
+      int ranks[] = { 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14 };
+      shuffle(std::begin(ranks), std::end(ranks), generator);
+      const int *take = ranks;
+
+      for (std::size_t k = 0; k < _shaped.size(); ++k)
+        for (int length = lengths[4 * k + suit]; length--;)
+          deal[_shaped[k]].set({ Strain(suit), *take++ });
+
+      while (take != std::end(ranks))
+        pool.emplace_back(Strain(suit), *take++);
+    }
+
+    shuffle(pool.begin(), pool.end(), generator);
+    auto take = pool.cbegin();
+
+    for (int seat = 0; seat < 4; ++seat)
+      if (std::find(_shaped.begin(), _shaped.end(), Seat(seat)) == _shaped.end())
+        for (int slots = 13; slots--;)
+          deal[Seat(seat)].set(*take++);
+
+    if (checkResidual(deal))
+      return deal;
+  }
+
+  throw std::runtime_error("Bridge::Dealer: no deal accepted after " + std::to_string(maxAttempts) + " draws");
+}
+
+void Bridge::Dealer::operator()(std::span<Bridge::Deal> deals, std::uint64_t seed, std::uint64_t first) const
+{
+  parallelFor(deals.size(), [=, this](std::size_t i)
+  {
+    Philox generator(seed, first + i);
+    deals[i] = (*this)(generator);
+  }, 256);
+}
@@ -0,0 +1,140 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Binomial.hpp"
+#include "Parallel.hpp"
+#include <Bridge/Enumerator.hpp>
+#include <boost/container/small_vector.hpp>
+#include <limits>
+#include <stdexcept>
+
+Bridge::Enumerator::Enumerator(const Deal &partial):
+  _partial(partial),
+  _slots(),
+  _size(1)
+{
+  unsigned dealt[4] = {};
+  std::size_t known = 0;
+
+  for (int seat = 0; seat < 4; ++seat) {
+    const Hand &hand = partial[Seat(seat)];
+
+    if (hand.size() > 13)
+      throw std::invalid_argument("A hand has more than 13 cards");
+
+    _slots[seat] = 13 - hand.size();
+    known += hand.size();
+
+    for (int suit = 0; suit < 4; ++suit)
+      dealt[suit] |= hand[Strain(suit)].bits();
+  }
+
+  for (int suit = 0; suit < 4; ++suit)
+    for (int rank = 2; rank <= 14; ++rank)
+      if (!(dealt[suit] >> rank & 1))
+        _cards.emplace_back(Strain(suit), rank);
+
+  if (known + _cards.size() != 52)
+    throw std::invalid_argument("A card is dealt twice");
+
+  int left = _cards.size();
+
+  for (int seat = 0; seat < 4; ++seat) {
+    const std::uint64_t combinations = choose(left, _slots[seat]);
+    left -= _slots[seat];
+
+    if (_size > std::numeric_limits<std::uint64_t>::max() / combinations)
+      _size = std::numeric_limits<std::uint64_t>::max();
+    else
+      _size *= combinations;
+  }
+}
+
+Bridge::Deal Bridge::Enumerator::operator[](std::uint64_t index) const
+{
+  boost::container::small_vector<Card, 52> pool(_cards.begin(), _cards.end());
+  Deal deal = _partial;
+
+  for (int seat = 0; seat < 4; ++seat) {
+    const int n = pool.size();
+    const int k = _slots[seat];
+    const std::uint64_t combinations = choose(n, k);
+
+    std::uint64_t rank = index % combinations;
+    index /= combinations;
+
+    // Positions of the combination from the highest
+    bool chosen[52] = {};
+
+    for (int i = k, c = n - 1; i > 0; --i, --c) {
+      while (choose(c, i) > rank)
+        --c;
+
+      rank -= choose(c, i);
+      chosen[c] = true;
+    }
+
+    std::size_t rest = 0;
+
+    for (int c = 0; c < n; ++c) {
+      if (chosen[c])
+        deal[Seat(seat)].set(pool[c]);
+      else
+        pool[rest++] = pool[c];
+    }
+
+    pool.erase(pool.begin() + rest, pool.end());
+  }
+
+  return deal;
+}
+
+std::uint64_t Bridge::Enumerator::rank(const Deal &deal) const
+{
+  boost::container::small_vector<Card, 52> pool(_cards.begin(), _cards.end());
+  std::uint64_t index = 0;
+  std::uint64_t radix = 1;
+
+  for (int seat = 0; seat < 4; ++seat) {
+    const Hand &hand = deal[Seat(seat)];
+    const int n = pool.size();
+    std::uint64_t rank = 0;
+    std::size_t rest = 0;
+    int i = 0;
+
+    for (int c = 0; c < n; ++c) {
+      if (hand[pool[c].suit()].test(pool[c].rank()))
+        rank += choose(c, ++i);
+      else
+        pool[rest++] = pool[c];
+    }
+
+    if (i != _slots[seat])
+      throw std::invalid_argument("The deal does not complete the partial deal");
+
+    index += rank * radix;
+    radix *= choose(n, _slots[seat]);
+    pool.erase(pool.begin() + rest, pool.end());
+  }
+
+  return index;
+}
+
+void Bridge::Enumerator::operator()(std::span<Deal> deals, std::uint64_t first) const
+{
+  parallelFor(deals.size(), [&](std::size_t i) { deals[i] = (*this)[first + i]; }, 1024);
+}
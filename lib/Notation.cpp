@@ -0,0 +1,335 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Bridge/Notation.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+// Rank of each character, or 0 if it is not a rank
+static constexpr auto ranks = []
+{
+  std::array<std::uint8_t, 256> table {};
+  const char symbols[] = "23456789TJQKA";
+
+  for (int rank = 2; rank <= 14; ++rank) {
+    const unsigned char c = symbols[rank - 2];
+    table[c] = rank;
+    table[c | 0x20] = rank;
+  }
+
+  return table;
+}();
+
+static int getSeat(char c)
+{
+  switch (c) {
+    case 'N': case 'n': return 0;
+    case 'E': case 'e': return 1;
+    case 'S': case 's': return 2;
+    case 'W': case 'w': return 3;
+    default: return -1;
+  }
+}
+
+static int getSuit(char c)
+{
+  switch (c) {
+    case 'C': case 'c': return 0;
+    case 'D': case 'd': return 1;
+    case 'H': case 'h': return 2;
+    case 'S': case 's': return 3;
+    default: return -1;
+  }
+}
+
+// Read ranks into a holding, stopping at the first non-rank
+static const char *parseRanks(const char *first, const char *last, Bridge::Holding &holding)
+{
+  unsigned bits = holding.bits();
+
+  for (; first != last; ++first) {
+    const unsigned rank = ranks[static_cast<unsigned char>(*first)];
+
+    if (!rank)
+      break;
+
+    if (bits >> rank & 1)
+      return nullptr;
+
+    bits |= 1u << rank;
+  }
+
+  holding = Bridge::Holding(static_cast<std::uint16_t>(bits));
+  return first;
+}
+
+// Check that no card is in two hands
+static bool isDisjoint(const Bridge::Deal &deal)
+{
+  for (int suit = 0; suit < 4; ++suit) {
+    unsigned cards = 0;
+    unsigned count = 0;
+
+    for (int seat = 0; seat < 4; ++seat) {
+      const Bridge::Holding holding = deal[Bridge::Seat(seat)][Bridge::Strain(suit)];
+      cards |= holding.bits();
+      count += holding.size();
+    }
+
+    if (count != static_cast<unsigned>(__builtin_popcount(cards)))
+      return false;
+  }
+
+  return true;
+}
+
+std::from_chars_result Bridge::parsePBN(const char *first, const char *last, Bridge::Deal &deal)
+{
+  const int seat = first == last ? -1 : getSeat(*first);
+
+  if (seat < 0 || last - first < 2 || first[1] != ':')
+    return { first, std::errc::invalid_argument };
+
+  const char *start = first;
+  Deal result;
+  first += 2;
+
+  for (int k = 0; k < 4; ++k) {
+    if (k) {
+      if (first == last || *first != ' ')
+        return { first, std::errc::invalid_argument };
+
+      ++first;
+    }
+
+    if (first != last && *first == '-') {
+      ++first;
+      continue;
+    }
+
+    Hand &hand = result[Seat((seat + k) % 4)];
+
+    for (int suit = 3; suit >= 0; --suit) {
+      if (suit != 3) {
+        if (first == last || *first != '.')
+          return { first, std::errc::invalid_argument };
+
+        ++first;
+      }
+
+      if (!(first = parseRanks(first, last, hand[Strain(suit)])))
+        return { start, std::errc::invalid_argument };
+    }
+
+    if (hand.size() != 13)
+      return { first, std::errc::invalid_argument };
+  }
+
+  if (!isDisjoint(result))
+    return { start, std::errc::invalid_argument };
+
+  deal = result;
+  return { first, std::errc() };
+}
+
+std::from_chars_result Bridge::parseLIN(const char *first, const char *last, Bridge::Deal &deal)
+{
+  const char *start = first;
+
+  if (last - first >= 3 && !std::memcmp(first, "md|", 3))
+    first += 3;
+
+  // Skip the dealer
+  if (first != last && *first >= '1' && *first <= '4')
+    ++first;
+
+  Deal result;
+  int given = 0;
+
+  for (; given < 4 && first != last && *first != '|'; ++given) {
+    if (given && *first++ != ',')
+      return { first - 1, std::errc::invalid_argument };
+
+    // South, West, North, East
+    Hand &hand = result[Seat((given + 2) % 4)];
+
+    for (int suit; first != last && (suit = getSuit(*first)) >= 0;)
+      if (!(first = parseRanks(first + 1, last, hand[Strain(suit)])))
+        return { start, std::errc::invalid_argument };
+
+    if (!hand.empty() && hand.size() != 13)
+      return { first, std::errc::invalid_argument };
+  }
+
+  // A trailing comma leaves the last hand empty
+  if (first != last && *first == ',')
+    ++first;
+
+  if (first != last && *first == '|')
+    ++first;
+
+  if (!isDisjoint(result))
+    return { start, std::errc::invalid_argument };
+
+  // Complete East from the other hands
+  if (result[Seat::E].empty() && result[Seat::S].size() + result[Seat::W].size() + result[Seat::N].size() == 39) {
+    for (int suit = 0; suit < 4; ++suit) {
+      const Strain strain = Strain(suit);
+      const unsigned dealt = result[Seat::S][strain].bits() | result[Seat::W][strain].bits() | result[Seat::N][strain].bits();
+      result[Seat::E][strain] = Holding(static_cast<std::uint16_t>(~dealt & 0x7FFC));
+    }
+  }
+
+  deal = result;
+  return { first, std::errc() };
+}
+
+std::to_chars_result Bridge::formatPBN(char *first, char *last, const Bridge::Deal &deal)
+{
+  const char table[] = "23456789TJQKA";
+  std::size_t size = 2 + 3;
+
+  for (int seat = 0; seat < 4; ++seat) {
+    const std::size_t cards = deal[Seat(seat)].size();
+    size += cards ? cards + 3 : 1;
+  }
+
+  if (last - first < static_cast<std::ptrdiff_t>(size))
+    return { last, std::errc::value_too_large };
+
+  *first++ = 'N';
+  *first++ = ':';
+
+  for (int seat = 0; seat < 4; ++seat) {
+    if (seat)
+      *first++ = ' ';
+
+    if (deal[Seat(seat)].empty()) {
+      *first++ = '-';
+      continue;
+    }
+
+    for (int suit = 3; suit >= 0; --suit) {
+      if (suit != 3)
+        *first++ = '.';
+
+      const Holding holding = deal[Seat(seat)][Strain(suit)];
+
+      for (int rank = 14; rank > 1; --rank)
+        if (holding.test(rank))
+          *first++ = table[rank - 2];
+    }
+  }
+
+  return { first, std::errc() };
+}
+
+std::from_chars_result Bridge::scanDeal(const char *first, const char *last, Bridge::Deal &deal)
+{
+  while (first != last) {
+    const char *end = static_cast<const char *>(std::memchr(first, '\n', last - first));
+    const std::string_view line(first, end ? end : last);
+    const char *next = end ? end + 1 : last;
+    std::from_chars_result result = { next, std::errc::result_out_of_range };
+
+    if (line.starts_with("[Deal \"")) {
+      result = parsePBN(line.data() + 7, line.data() + line.size(), deal);
+    }
+    else if (line.size() >= 2 && line[1] == ':' && getSeat(line[0]) >= 0) {
+      // A bare line like "N: see notes" may be prose, so skip it unless it parses
+      if (parsePBN(line.data(), line.data() + line.size(), deal).ec == std::errc())
+        result.ec = std::errc();
+    }
+    else if (const std::size_t md = line.find("md|"); md != std::string_view::npos)
+      result = parseLIN(line.data() + md, line.data() + line.size(), deal);
+
+    if (result.ec == std::errc())
+      return { next, std::errc() };
+
+    if (result.ec != std::errc::result_out_of_range)
+      return result;
+
+    first = next;
+  }
+
+  return { last, std::errc::result_out_of_range };
+}
+
+struct Bridge::DealText::Storage
+{
+  boost::interprocess::file_mapping file;
+  boost::interprocess::mapped_region region;
+};
+
+Bridge::DealText::DealText(const std::string &path):
+  _size(0)
+{
+  namespace ipc = boost::interprocess;
+
+  if (std::filesystem::file_size(path)) {
+    ipc::file_mapping file(path.c_str(), ipc::read_only);
+    ipc::mapped_region region(file, ipc::read_only);
+
+    region.advise(ipc::mapped_region::advice_sequential);
+    _text = std::string_view(static_cast<const char *>(region.get_address()), region.get_size());
+    _storage.reset(new Storage { std::move(file), std::move(region) });
+  }
+
+  const char *last = _text.data() + _text.size();
+  Deal deal;
+
+  for (auto result = scanDeal(_text.data(), last, deal); result.ec != std::errc::result_out_of_range;
+      result = scanDeal(result.ptr, last, deal)) {
+    if (result.ec != std::errc())
+      throw std::runtime_error("Bridge::DealText: malformed deal at byte " + std::to_string(result.ptr - _text.data()) + " of " + path);
+
+    if (deal[Seat::N].size() + deal[Seat::E].size() + deal[Seat::S].size() + deal[Seat::W].size() != 52)
+      throw std::runtime_error("Bridge::DealText: incomplete deal before byte " + std::to_string(result.ptr - _text.data()) + " of " + path);
+
+    ++_size;
+  }
+}
+
+Bridge::DealText::~DealText() = default;
+
+Bridge::Source Bridge::DealText::source(std::size_t first, std::size_t last) const
+{
+  last = std::min(last, _size);
+  first = std::min(first, last);
+
+  const char *cursor = _text.data();
+  const char *end = _text.data() + _text.size();
+  Deal deal;
+
+  for (std::size_t i = 0; i < first; ++i)
+    cursor = scanDeal(cursor, end, deal).ptr;
+
+  return [cursor, end, count = last - first](std::span<Deal> buffer) mutable
+  {
+    const std::size_t size = std::min(buffer.size(), count);
+
+    for (std::size_t i = 0; i < size; ++i)
+      cursor = scanDeal(cursor, end, buffer[i]).ptr;
+
+    count -= size;
+    return size;
+  };
+}
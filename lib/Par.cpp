@@ -0,0 +1,200 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Parallel.hpp"
+#include <Bridge/Par.hpp>
+#include <algorithm>
+#include <limits>
+
+int Bridge::getScore(const Bridge::Contract &contract, int tricks, bool vulnerable)
+{
+  if (!contract.level)
+    return 0;
+
+  const int needed = contract.level + 6;
+
+  if (tricks < needed) {
+    const int under = needed - tricks;
+
+    if (!contract.doubled)
+      return -(vulnerable ? 100 : 50) * under;
+
+    // First undertrick, second and third, and the rest
+    const int first = vulnerable ? 200 : 100;
+    const int second = vulnerable ? 300 : 200;
+    return -(first + second * std::min(under - 1, 2) + 300 * std::max(under - 3, 0));
+  }
+
+  const bool minor = contract.strain == Strain::C || contract.strain == Strain::D;
+  const int perTrick = minor ? 20 : 30;
+  const int contracted = (perTrick * contract.level + 10 * (contract.strain == Strain::N)) << contract.doubled;
+  const int over = tricks - needed;
+
+  int score = contracted + (contracted >= 100 ? (vulnerable ? 500 : 300) : 50);
+
+  if (contract.level == 6)
+    score += vulnerable ? 750 : 500;
+
+  if (contract.level == 7)
+    score += vulnerable ? 1500 : 1000;
+
+  if (contract.doubled)
+    return score + 50 + over * (vulnerable ? 200 : 100);
+
+  return score + over * perTrick;
+}
+
+namespace {
+
+// Auction where the sides take turns to outbid or pass
+//
+// Bids are numbered from 0 for 1C to 34 for 7NT.  After a side bids, the
+// other side either passes, ending the auction, or bids higher.  Values are
+// for the side that bid.
+class Auction
+{
+  static constexpr int bids = 35;
+  static constexpr int lowest = std::numeric_limits<int>::min() / 2;
+
+  // Declarer and score of each side playing each bid
+  Bridge::Seat _declarers[2][bids];
+  int _scores[2][bids];
+
+  // Best value for each side bidding at least the given bid
+  int _best[2][bids + 1];
+
+  // The lowest bid attaining _best
+  int _choices[2][bids + 1];
+
+  Bridge::Seat _dealer;
+
+  Bridge::Contract getContract(int side, int bid) const;
+
+public:
+  Auction(const Bridge::Result &result, Bridge::Vulnerability vulnerability, Bridge::Seat dealer, Bridge::StrainMask mask);
+  Bridge::Par operator()() const;
+};
+
+} // namespace
+
+Auction::Auction(const Bridge::Result &result, Bridge::Vulnerability vulnerability, Bridge::Seat dealer, Bridge::StrainMask mask):
+  _dealer(dealer)
+{
+  const bool masked[] = { bool(mask.c), bool(mask.d), bool(mask.h), bool(mask.s), bool(mask.n) };
+
+  const int vulnerable[] = {
+    vulnerability == Bridge::Vulnerability::NS || vulnerability == Bridge::Vulnerability::Both,
+    vulnerability == Bridge::Vulnerability::EW || vulnerability == Bridge::Vulnerability::Both,
+  };
+
+  for (int side = 0; side < 2; ++side) {
+    // Prefer the partner who would bid first
+    Bridge::Seat first = Bridge::Seat(side);
+    Bridge::Seat second = Bridge::Seat(side + 2);
+
+    if ((side - static_cast<int>(dealer) + 4) % 4 > 1)
+      std::swap(first, second);
+
+    for (int bid = 0; bid < bids; ++bid) {
+      const Bridge::Strain strain = Bridge::Strain(bid % 5);
+      const int tricks = std::max(result(strain, first), result(strain, second));
+      const Bridge::Seat declarer = result(strain, first) < tricks ? second : first;
+      const int level = bid / 5 + 1;
+
+      _declarers[side][bid] = declarer;
+      _scores[side][bid] = Bridge::getScore({ level, strain, declarer, tricks < level + 6 }, tricks, vulnerable[side]);
+    }
+  }
+
+  _best[0][bids] = _best[1][bids] = lowest;
+  _choices[0][bids] = _choices[1][bids] = bids;
+
+  // Bids in masked strains are never made, as their tricks are unknown
+  for (int bid = bids - 1; bid >= 0; --bid) {
+    for (int side = 0; side < 2; ++side) {
+      if (masked[bid % 5]) {
+        _best[side][bid] = _best[side][bid + 1];
+        _choices[side][bid] = _choices[side][bid + 1];
+        continue;
+      }
+
+      const int value = std::min(_scores[side][bid], -_best[!side][bid + 1]);
+      const bool better = value >= _best[side][bid + 1];
+
+      _best[side][bid] = better ? value : _best[side][bid + 1];
+      _choices[side][bid] = better ? bid : _choices[side][bid + 1];
+    }
+  }
+}
+
+Bridge::Contract Auction::getContract(int side, int bid) const
+{
+  const int level = bid / 5 + 1;
+  const Bridge::Strain strain = Bridge::Strain(bid % 5);
+  return { level, strain, _declarers[side][bid], _scores[side][bid] < 0 };
+}
+
+Bridge::Par Auction::operator()() const
+{
+  // The dealer side opens if it profits, or else when the other side does
+  const int opener = static_cast<int>(_dealer) % 2;
+  const int opening = _best[opener][0];
+  const int response = _best[!opener][0];
+
+  int side = opener;
+
+  if (opening < 0) {
+    if (response <= 0)
+      return {};
+
+    if (opening < -response)
+      side = !opener;
+  }
+
+  int bid = _choices[side][0];
+
+  // Follow the auction until the other side passes
+  while (-_scores[side][bid] < _best[!side][bid + 1]) {
+    side = !side;
+    bid = _choices[side][bid + 1];
+  }
+
+  const int score = _scores[side][bid];
+  return { side ? -score : score, getContract(side, bid) };
+}
+
+Bridge::Par Bridge::getPar(const Bridge::Result &result, Bridge::Vulnerability vulnerability, Bridge::Seat dealer, Bridge::StrainMask mask)
+{
+  return Auction(result, vulnerability, dealer, mask)();
+}
+
+std::array<Bridge::Par, 4> Bridge::getPar(const Bridge::Result &result, Bridge::Seat dealer, Bridge::StrainMask mask)
+{
+  return {
+    getPar(result, Vulnerability::None, dealer, mask),
+    getPar(result, Vulnerability::NS, dealer, mask),
+    getPar(result, Vulnerability::EW, dealer, mask),
+    getPar(result, Vulnerability::Both, dealer, mask),
+  };
+}
+
+std::vector<std::array<Bridge::Par, 4>> Bridge::getPar(std::span<const Bridge::Result> results, Bridge::Seat dealer, Bridge::StrainMask mask)
+{
+  std::vector<std::array<Par, 4>> pars(results.size());
+  parallelFor(results.size(), [&](std::size_t i) { pars[i] = getPar(results[i], dealer, mask); }, 1024);
+  return pars;
+}
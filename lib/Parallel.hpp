@@ -0,0 +1,73 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BRIDGE_PARALLEL_HPP
+#define BRIDGE_PARALLEL_HPP
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Bridge {
+
+// Call f(i) for every i in [0, size), split into contiguous chunks across
+// hardware threads.  Batches smaller than grain run on the calling thread,
+// as thread startup is not worth it.  The first exception thrown by f is
+// rethrown after all chunks end.
+template <typename F>
+void parallelFor(std::size_t size, const F &f, std::size_t grain = 4096)
+{
+  const std::size_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+  const std::size_t threads = std::clamp<std::size_t>(size / grain, 1, cores);
+  const std::size_t chunk = (size + threads - 1) / threads;
+
+  std::mutex mutex;
+  std::exception_ptr error;
+
+  const auto run = [&](std::size_t begin)
+  {
+    try {
+      for (std::size_t i = begin; i < std::min(begin + chunk, size); ++i)
+        f(i);
+    }
+    catch (...) {
+      const std::lock_guard lock(mutex);
+
+      if (!error)
+        error = std::current_exception();
+    }
+  };
+
+  {
+    std::vector<std::jthread> workers;
+    workers.reserve(threads - 1);
+
+    for (std::size_t begin = chunk; begin < size; begin += chunk)
+      workers.emplace_back(run, begin);
+
+    run(0);
+  }
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
+} // namespace Bridge
+
+#endif
@@ -0,0 +1,199 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Bridge/ResultBatch.hpp>
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+using Counts = std::array<std::size_t, 16>;
+
+// Count nibbles by value
+//
+// With AVX2, each value below 14 has a vector of byte counters, which take at
+// most 2 per iteration and are widened with SAD before they overflow.  Values
+// 14 and 15 are never tricks, so they are only counted in the scalar tail.
+static void countNibbles(const std::uint8_t *bytes, std::size_t size, Counts &counts)
+{
+  std::size_t i = 0;
+
+#ifdef __AVX2__
+  const __m256i mask = _mm256_set1_epi8(0x0F);
+  const __m256i zero = _mm256_setzero_si256();
+
+  while (i + 32 <= size) {
+    const std::size_t end = std::min(size & ~std::size_t(31), i + 127 * 32);
+    __m256i sums[14];
+
+    for (__m256i &sum : sums)
+      sum = zero;
+
+    for (; i < end; i += 32) {
+      const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes + i));
+      const __m256i low = _mm256_and_si256(x, mask);
+      const __m256i high = _mm256_and_si256(_mm256_srli_epi16(x, 4), mask);
+
+      for (int v = 0; v < 14; ++v) {
+        const __m256i value = _mm256_set1_epi8(v);
+        sums[v] = _mm256_sub_epi8(sums[v], _mm256_cmpeq_epi8(low, value));
+        sums[v] = _mm256_sub_epi8(sums[v], _mm256_cmpeq_epi8(high, value));
+      }
+    }
+
+    for (int v = 0; v < 14; ++v) {
+      const __m256i wide = _mm256_sad_epu8(sums[v], zero);
+      counts[v] += _mm256_extract_epi64(wide, 0) + _mm256_extract_epi64(wide, 1)
+                 + _mm256_extract_epi64(wide, 2) + _mm256_extract_epi64(wide, 3);
+    }
+  }
+#endif
+
+  for (; i < size; ++i) {
+    ++counts[bytes[i] & 15];
+    ++counts[bytes[i] >> 4];
+  }
+}
+
+Bridge::ResultBatch::ResultBatch(std::span<const Bridge::Result> results)
+{
+  reserve(results.size());
+
+  for (const Result &result : results)
+    push_back(result);
+}
+
+void Bridge::ResultBatch::clear()
+{
+  for (auto &column : _columns)
+    column.clear();
+
+  _size = 0;
+}
+
+void Bridge::ResultBatch::reserve(std::size_t capacity)
+{
+  for (auto &column : _columns)
+    column.reserve((capacity + 1) / 2);
+}
+
+void Bridge::ResultBatch::push_back(const Bridge::Result &result)
+{
+  for (int strain = 0; strain < 5; ++strain) {
+    for (int seat = 0; seat < 4; ++seat) {
+      std::vector<std::uint8_t> &column = _columns[4 * strain + seat];
+      const unsigned tricks = result(Strain(strain), Seat(seat));
+
+      if (_size & 1)
+        column.back() = (column.back() & 0x0F) | tricks << 4;
+      else
+        column.push_back(0xF0 | tricks);
+    }
+  }
+
+  ++_size;
+}
+
+Bridge::Result Bridge::ResultBatch::operator[](std::size_t i) const
+{
+  const int shift = 4 * (i & 1);
+  Result result;
+
+  for (int strain = 0; strain < 5; ++strain)
+    for (int seat = 0; seat < 4; ++seat)
+      result.set(Strain(strain), Seat(seat), _columns[4 * strain + seat][i / 2] >> shift & 15);
+
+  return result;
+}
+
+void Bridge::ResultBatch::set(std::size_t i, const Bridge::Result &result)
+{
+  const int shift = 4 * (i & 1);
+
+  for (int strain = 0; strain < 5; ++strain) {
+    for (int seat = 0; seat < 4; ++seat) {
+      std::uint8_t &byte = _columns[4 * strain + seat][i / 2];
+      byte = (byte & ~(15 << shift)) | result(Strain(strain), Seat(seat)) << shift;
+    }
+  }
+}
+
+Bridge::ResultBatch::Histogram Bridge::ResultBatch::histogram(Bridge::Strain strain, Bridge::Seat seat, std::span<const std::uint8_t> filter) const
+{
+  const std::span<const std::uint8_t> bytes = column(strain, seat);
+  Counts counts = {};
+
+  if (filter.empty()) {
+    countNibbles(bytes.data(), bytes.size(), counts);
+  }
+  else {
+    assert(filter.size() == _size);
+
+    // Overwrite unselected tricks with 15 in blocks that stay in L1.  The
+    // loop is branchless so that compilers vectorize it.
+    const std::size_t pairs = _size / 2;
+    std::uint8_t block[4096];
+
+    for (std::size_t begin = 0; begin < pairs; begin += sizeof(block)) {
+      const std::size_t size = std::min(sizeof(block), pairs - begin);
+      const std::uint8_t *bits = bytes.data() + begin;
+      const std::uint8_t *selected = filter.data() + 2 * begin;
+
+      for (std::size_t j = 0; j < size; ++j)
+        block[j] = bits[j] | (selected[2 * j] == 0) * 0x0F | (selected[2 * j + 1] == 0) * 0xF0;
+
+      countNibbles(block, size, counts);
+    }
+
+    if (_size & 1 && filter.back())
+      ++counts[bytes.back() & 15];
+  }
+
+  Histogram histogram;
+  std::copy_n(counts.begin(), histogram.size(), histogram.begin());
+  return histogram;
+}
+
+double Bridge::ResultBatch::mean(Bridge::Strain strain, Bridge::Seat seat, std::span<const std::uint8_t> filter) const
+{
+  const Histogram counts = histogram(strain, seat, filter);
+  std::size_t total = 0;
+  std::size_t tricks = 0;
+
+  for (std::size_t v = 0; v < counts.size(); ++v) {
+    total += counts[v];
+    tricks += v * counts[v];
+  }
+
+  return double(tricks) / total;
+}
+
+std::size_t Bridge::ResultBatch::count(Bridge::Strain strain, Bridge::Seat seat, int tricks, std::span<const std::uint8_t> filter) const
+{
+  const Histogram counts = histogram(strain, seat, filter);
+  return std::accumulate(counts.begin() + std::clamp(tricks, 0, 14), counts.end(), std::size_t());
+}
+
+double Bridge::ResultBatch::probability(Bridge::Strain strain, Bridge::Seat seat, int tricks, std::span<const std::uint8_t> filter) const
+{
+  const Histogram counts = histogram(strain, seat, filter);
+  const std::size_t total = std::accumulate(counts.begin(), counts.end(), std::size_t());
+  return double(std::accumulate(counts.begin() + std::clamp(tricks, 0, 14), counts.end(), std::size_t())) / total;
+}
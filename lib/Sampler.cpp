@@ -0,0 +1,200 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Parallel.hpp"
+#include <Bridge/Random.hpp>
+#include <Bridge/Sampler.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// Fractional part of the golden ratio, spreading strata evenly over indices
+static const double golden = 0.6180339887498949;
+
+static int countSlots(const Bridge::Deal &deal, Bridge::Seat seat)
+{
+  return 13 - static_cast<int>(deal[seat].size());
+}
+
+// Ranks of a suit not in the deal
+static std::vector<int> getUnknown(const Bridge::Deal &deal, Bridge::Strain suit)
+{
+  unsigned known = 0;
+  std::vector<int> ranks;
+
+  for (int seat = 0; seat < 4; ++seat)
+    known |= deal[Bridge::Seat(seat)][suit].bits();
+
+  for (int rank = 2; rank <= 14; ++rank)
+    if (!(known >> rank & 1))
+      ranks.push_back(rank);
+
+  return ranks;
+}
+
+static double choose(int n, int k)
+{
+  return std::exp(std::lgamma(n + 1) - std::lgamma(k + 1) - std::lgamma(n - k + 1));
+}
+
+Bridge::Sampler::Sampler(const Deal &partial, Mode mode, Likelihood likelihood):
+  _partial(partial),
+  _mode(mode),
+  _likelihood(std::move(likelihood)),
+  _hidden()
+{
+  for (int suit = 0; suit < 4; ++suit) {
+    unsigned cards = 0;
+    int count = 0;
+
+    for (int seat = 0; seat < 4; ++seat) {
+      const Holding holding = partial[Seat(seat)][Strain(suit)];
+      cards |= holding.bits();
+      count += holding.size();
+    }
+
+    if (count != __builtin_popcount(cards))
+      throw std::invalid_argument("A card is dealt twice");
+  }
+
+  std::vector<Seat> hidden;
+
+  for (int seat = 0; seat < 4; ++seat) {
+    if (countSlots(partial, Seat(seat)) < 0)
+      throw std::invalid_argument("A hand has more than 13 cards");
+
+    if (countSlots(partial, Seat(seat)) > 0)
+      hidden.push_back(Seat(seat));
+  }
+
+  if (mode == Mode::Antithetic) {
+    bool found = false;
+
+    for (std::size_t i = 0; !found && i < hidden.size(); ++i)
+      for (std::size_t j = i + 1; !found && j < hidden.size(); ++j)
+        if ((found = countSlots(partial, hidden[i]) == countSlots(partial, hidden[j])))
+          _hidden = { hidden[i], hidden[j] };
+
+    if (!found)
+      throw std::invalid_argument("Antithetic sampling needs two hidden seats of the same size");
+  }
+
+  if (mode == Mode::Stratified) {
+    if (hidden.size() != 2)
+      throw std::invalid_argument("Stratified sampling needs exactly two hidden seats");
+
+    _hidden = { hidden[0], hidden[1] };
+
+    const int slots = countSlots(partial, hidden[0]);
+    const int total = slots + countSlots(partial, hidden[1]);
+    std::array<int, 4> unknown;
+
+    for (int suit = 0; suit < 4; ++suit)
+      unknown[suit] = getUnknown(partial, Strain(suit)).size();
+
+    double sum = 0;
+
+    for (int c = 0; c <= unknown[0]; ++c)
+      for (int d = 0; d <= unknown[1]; ++d)
+        for (int h = 0; h <= unknown[2]; ++h) {
+          const int s = slots - c - d - h;
+
+          if (s < 0 || s > unknown[3])
+            continue;
+
+          sum += choose(unknown[0], c) * choose(unknown[1], d) * choose(unknown[2], h) * choose(unknown[3], s)
+            / choose(total, slots);
+
+          _strata.push_back({ c, d, h, s });
+          _cumulative.push_back(sum);
+        }
+
+    // Guard against rounding in the last stratum
+    _cumulative.back() = 1;
+  }
+}
+
+// Deal a stratum picked by a Kronecker sequence with a random start, so each
+// sample is still a uniform completion
+Bridge::Deal Bridge::Sampler::stratify(std::uint64_t seed, std::uint64_t index) const
+{
+  Philox start(seed, ~std::uint64_t{});
+  const double u = std::fmod(getCanonical(start) + golden * static_cast<double>(index), 1.0);
+  const std::size_t stratum = std::upper_bound(_cumulative.begin(), _cumulative.end(), u) - _cumulative.begin();
+  const std::array<int, 4> &lengths = _strata[std::min(stratum, _strata.size() - 1)];
+
+  Philox generator(seed, index);
+  Deal deal = _partial;
+
+  for (int suit = 0; suit < 4; ++suit) {
+    std::vector<int> ranks = getUnknown(_partial, Strain(suit));
+    shuffle(ranks.begin(), ranks.end(), generator);
+
+    for (std::size_t i = 0; i < ranks.size(); ++i)
+      deal[_hidden[i >= static_cast<std::size_t>(lengths[suit])]][Strain(suit)].set(ranks[i]);
+  }
+
+  return deal;
+}
+
+void Bridge::Sampler::operator()(std::span<Deal> deals, std::span<double> weights, std::uint64_t seed, std::uint64_t first) const
+{
+  parallelFor(deals.size(), [&](std::size_t i)
+  {
+    const std::uint64_t index = first + i;
+    Deal &deal = deals[i];
+
+    switch (_mode) {
+      case Mode::Plain: {
+        Philox generator(seed, index);
+        deal = _partial;
+        fillRandomCards(deal, generator);
+        break;
+      }
+
+      case Mode::Antithetic: {
+        Philox generator(seed, index / 2);
+        deal = _partial;
+        fillRandomCards(deal, generator);
+
+        // Swap the dealt cards, keeping the preset ones in place
+        if (index % 2) {
+          Hand &a = deal[_hidden[0]];
+          Hand &b = deal[_hidden[1]];
+
+          for (int suit = 0; suit < 4; ++suit) {
+            const Strain strain = Strain(suit);
+            const unsigned presetA = _partial[_hidden[0]][strain].bits();
+            const unsigned presetB = _partial[_hidden[1]][strain].bits();
+            const unsigned dealtA = a[strain].bits() & ~presetA;
+            const unsigned dealtB = b[strain].bits() & ~presetB;
+
+            a[strain] = Holding(static_cast<std::uint16_t>(presetA | dealtB));
+            b[strain] = Holding(static_cast<std::uint16_t>(presetB | dealtA));
+          }
+        }
+        break;
+      }
+
+      case Mode::Stratified:
+        deal = stratify(seed, index);
+        break;
+    }
+
+    weights[i] = weigh(deal);
+  }, 1024);
+}
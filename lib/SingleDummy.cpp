@@ -0,0 +1,292 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Bridge/Enumerator.hpp>
+#include <Bridge/SingleDummy.hpp>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <numeric>
+
+Bridge::Analysis::Analysis(std::span<const Contract> contracts):
+  contracts(contracts.begin(), contracts.end()),
+  tricks(contracts.size()),
+  scores(contracts.size())
+{}
+
+static bool isVulnerable(Bridge::Seat declarer, Bridge::Vulnerability vulnerability)
+{
+  switch (vulnerability) {
+    case Bridge::Vulnerability::NS:
+      return static_cast<int>(declarer) % 2 == 0;
+    case Bridge::Vulnerability::EW:
+      return static_cast<int>(declarer) % 2 == 1;
+    case Bridge::Vulnerability::Both:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void Bridge::Analysis::add(const Result &result, Vulnerability vulnerability, double weight)
+{
+  add(std::span(&result, 1), std::span(&weight, 1), vulnerability);
+}
+
+void Bridge::Analysis::add(std::span<const Result> results, std::span<const double> weights, Vulnerability vulnerability)
+{
+  Eigen::RowVectorXd observation = Eigen::RowVectorXd::Zero(contracts.size());
+  double weight = 0;
+
+  for (std::size_t k = 0; k < results.size(); ++k) {
+    for (std::size_t i = 0; i < contracts.size(); ++i) {
+      const Contract &contract = contracts[i];
+      const int taken = results[k](contract.strain, contract.declarer);
+
+      tricks[i][taken] += weights[k];
+      observation(i) += weights[k] * getScore(contract, taken, isVulnerable(contract.declarer, vulnerability));
+    }
+
+    weight += weights[k];
+  }
+
+  if (!weight)
+    return;
+
+  scores.add(observation / weight, weight);
+  squares += weight * weight;
+}
+
+double Bridge::Analysis::error(std::size_t i) const
+{
+  return std::sqrt(scores.comoment()(i, i) / scores.weight() / (size() - 1));
+}
+
+double Bridge::Analysis::error(std::size_t i, std::size_t j) const
+{
+  const Eigen::MatrixXd &comoment = scores.comoment();
+  const double variance = (comoment(i, i) + comoment(j, j) - 2 * comoment(i, j)) / scores.weight();
+  return std::sqrt(std::max(variance, 0.0) / (size() - 1));
+}
+
+double Bridge::Analysis::probability(std::size_t i) const
+{
+  const auto &distribution = tricks[i];
+  const auto first = distribution.begin() + contracts[i].level + 6;
+  const double total = std::accumulate(distribution.begin(), distribution.end(), 0.0);
+
+  return std::accumulate(first, distribution.end(), 0.0) / total;
+}
+
+void Bridge::Analysis::decide(double z)
+{
+  const Eigen::VectorXd &mean = scores.mean();
+  Eigen::Index index = 0;
+
+  mean.maxCoeff(&index);
+  best = index;
+  settled = squares && size() > 1;
+
+  for (std::size_t j = 0; settled && j < contracts.size(); ++j)
+    settled = j == best || mean(best) - mean(j) >= z * error(best, j);
+}
+
+Bridge::Analysis Bridge::analyze(const Deal &partial, std::span<const Contract> contracts, const Sampling &options)
+{
+  return analyze(Sampler(partial), contracts, options);
+}
+
+Bridge::Analysis Bridge::analyze(const Sampler &sampler, std::span<const Contract> contracts, const Sampling &options)
+{
+  Analysis analysis(contracts);
+
+  if (contracts.empty())
+    return analysis;
+
+  unsigned strains = 0;
+
+  for (const Contract &contract : contracts)
+    strains |= 1u << static_cast<int>(contract.strain);
+
+  const StrainMask mask = {
+    !(strains & 1), !(strains >> 1 & 1), !(strains >> 2 & 1), !(strains >> 3 & 1), !(strains >> 4 & 1),
+  };
+
+  const Enumerator enumerator(sampler.partial());
+  const bool exact = enumerator.size() <= options.exhaustive;
+  std::size_t produced = 0;
+
+  // Weights of drawn deals not yet solved, in stream order
+  std::deque<double> weights;
+
+  // Solved deals of an incomplete group
+  std::vector<Result> group;
+  std::vector<double> groupWeights;
+
+  // The source and the sink are called one at a time.  While DDS solves a
+  // pack, the sink takes the previous pack before the source draws the next,
+  // so the decision lags by the pack in flight, and up to one pack more than
+  // needed is solved after the analysis settles.
+  // Deals of zero weight add nothing, so they are dropped before DDS, along
+  // with groups where every deal has zero weight
+  const auto source = [&](std::span<Deal> buffer)
+  {
+    std::size_t size = 0;
+
+    while (!size) {
+      if (exact) {
+        const std::size_t count = std::min<std::uint64_t>(buffer.size(), enumerator.size() - produced);
+
+        if (!count)
+          break;
+
+        enumerator(buffer.first(count), produced);
+        produced += count;
+
+        for (std::size_t i = 0; i < count; ++i) {
+          if (const double weight = sampler.weigh(buffer[i])) {
+            buffer[size++] = buffer[i];
+            weights.push_back(weight);
+          }
+        }
+        continue;
+      }
+
+      if (produced >= options.minimum && analysis.settled)
+        break;
+
+      // Draw whole groups, so that produced stays aligned to them
+      const std::size_t group = sampler.group();
+      const std::size_t count = std::min(buffer.size(), options.maximum - produced) / group * group;
+
+      if (!count)
+        break;
+
+      std::vector<double> drawn(count);
+      sampler(buffer.first(count), drawn, options.seed, produced);
+      produced += count;
+
+      for (std::size_t i = 0; i < count; i += group) {
+        if (std::all_of(drawn.begin() + i, drawn.begin() + i + group, [](double weight) { return !weight; }))
+          continue;
+
+        for (std::size_t j = i; j < i + group; ++j) {
+          buffer[size++] = buffer[j];
+          weights.push_back(drawn[j]);
+        }
+      }
+    }
+
+    return size;
+  };
+
+  const auto sink = [&](std::span<const Deal>, std::span<const Result> results)
+  {
+    for (const Result &result : results) {
+      group.push_back(result);
+      groupWeights.push_back(weights.front());
+      weights.pop_front();
+
+      if (exact || group.size() == sampler.group()) {
+        analysis.add(group, groupWeights, options.vulnerability);
+        group.clear();
+        groupWeights.clear();
+      }
+    }
+
+    analysis.decide(options.z);
+  };
+
+  solve(source, sink, mask);
+
+  if (exact) {
+    analysis.exact = true;
+    analysis.settled = true;
+  }
+
+  return analysis;
+}
+
+void Bridge::LeadAnalysis::add(const Leads &leads, double weight)
+{
+  for (int suit = 0; suit < 4; ++suit) {
+    for (int rank = 2; rank <= 14; ++rank) {
+      const int taken = leads(Strain(suit), rank);
+
+      if (taken < 0)
+        continue;
+
+      const int card = 13 * suit + rank - 2;
+      weights[card] += weight;
+      tricks[card] += weight * taken;
+      sets[card] += weight * (taken < contract.level + 6);
+    }
+  }
+}
+
+double Bridge::LeadAnalysis::mean(Strain suit, int rank) const
+{
+  const int card = 13 * static_cast<int>(suit) + rank - 2;
+  return tricks[card] / weights[card];
+}
+
+double Bridge::LeadAnalysis::probability(Strain suit, int rank) const
+{
+  const int card = 13 * static_cast<int>(suit) + rank - 2;
+  return sets[card] / weights[card];
+}
+
+Bridge::LeadAnalysis Bridge::analyzeLeads(const Deal &partial, const Contract &contract, std::size_t number, std::uint64_t seed)
+{
+  return analyzeLeads(Sampler(partial), contract, number, seed);
+}
+
+Bridge::LeadAnalysis Bridge::analyzeLeads(const Sampler &sampler, const Contract &contract, std::size_t number, std::uint64_t seed)
+{
+  // Several batches of boards per call, a multiple of any group size
+  const std::size_t chunk = 1000;
+
+  LeadAnalysis analysis(contract);
+  std::vector<Deal> deals(chunk);
+  std::vector<double> weights(chunk);
+  std::vector<Query> queries(chunk);
+
+  for (std::size_t first = 0; first < number; first += chunk) {
+    const std::size_t size = std::min(chunk, number - first);
+    sampler(std::span(deals).first(size), std::span(weights).first(size), seed, first);
+
+    // Only deals of positive weight are worth solving
+    std::size_t kept = 0;
+
+    for (std::size_t i = 0; i < size; ++i) {
+      if (weights[i]) {
+        weights[kept] = weights[i];
+        queries[kept++] = { deals[i], contract.strain, contract.declarer };
+      }
+    }
+
+    if (!kept)
+      continue;
+
+    const std::vector<Leads> leads = solveLeads(std::span(queries).first(kept));
+
+    for (std::size_t i = 0; i < kept; ++i)
+      analysis.add(leads[i], weights[i]);
+  }
+
+  return analysis;
+}
@@ -0,0 +1,169 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Parallel.hpp"
+#include <Bridge/Symmetry.hpp>
+#include <algorithm>
+
+Bridge::Symmetry Bridge::inverse(const Bridge::Symmetry &symmetry)
+{
+  Symmetry result;
+
+  for (int suit = 0; suit < 4; ++suit)
+    result.suits[static_cast<int>(symmetry.suits[suit])] = Strain(suit);
+
+  result.rotation = (4 - symmetry.rotation) % 4;
+  return result;
+}
+
+Bridge::Deal Bridge::transform(const Bridge::Deal &deal, const Bridge::Symmetry &symmetry)
+{
+  Deal result;
+
+  for (int seat = 0; seat < 4; ++seat)
+    for (int suit = 0; suit < 4; ++suit)
+      result[Seat((seat + symmetry.rotation) % 4)][symmetry.suits[suit]] = deal[Seat(seat)][Strain(suit)];
+
+  return result;
+}
+
+Bridge::Result Bridge::transform(const Bridge::Result &result, const Bridge::Symmetry &symmetry)
+{
+  Result image;
+
+  for (int seat = 0; seat < 4; ++seat) {
+    const Seat target = Seat((seat + symmetry.rotation) % 4);
+
+    for (int suit = 0; suit < 4; ++suit)
+      image.set(symmetry.suits[suit], target, result(Strain(suit), Seat(seat)));
+
+    image.set(Strain::N, target, result(Strain::N, Seat(seat)));
+  }
+
+  return image;
+}
+
+// Holdings of a suit from North to West after rotation, as a sort key
+static std::uint64_t getColumn(const Bridge::Deal &deal, int suit, int rotation)
+{
+  std::uint64_t column = 0;
+
+  for (int seat = 0; seat < 4; ++seat)
+    column = column << 16 | deal[Bridge::Seat((seat + 4 - rotation) % 4)][Bridge::Strain(suit)].bits();
+
+  return column;
+}
+
+std::pair<Bridge::Deal, Bridge::Symmetry> Bridge::canonicalize(const Bridge::Deal &deal, Bridge::StrainMask mask)
+{
+  const bool masked[4] = { bool(mask.c), bool(mask.d), bool(mask.h), bool(mask.s) };
+  std::array<std::uint64_t, 4> best = {};
+  Symmetry symmetry;
+
+  for (int rotation = 0; rotation < 4; ++rotation) {
+    std::uint64_t columns[4];
+    std::array<std::uint64_t, 4> keys;
+    Symmetry candidate;
+    candidate.rotation = rotation;
+
+    for (int suit = 0; suit < 4; ++suit)
+      columns[suit] = getColumn(deal, suit, rotation);
+
+    // Within masked and unmasked suits respectively, send the suit with the
+    // smaller column to the lower strain
+    for (const bool group : { false, true }) {
+      int suits[4];
+      int size = 0;
+
+      for (int suit = 0; suit < 4; ++suit)
+        if (masked[suit] == group)
+          suits[size++] = suit;
+
+      int images[4];
+      std::copy_n(suits, size, images);
+
+      // Insertion sort, as there are at most 4 suits
+      for (int i = 1; i < size; ++i)
+        for (int j = i; j > 0 && columns[suits[j]] < columns[suits[j - 1]]; --j)
+          std::swap(suits[j], suits[j - 1]);
+
+      for (int i = 0; i < size; ++i) {
+        candidate.suits[suits[i]] = Strain(images[i]);
+        keys[images[i]] = columns[suits[i]];
+      }
+    }
+
+    if (!rotation || keys < best) {
+      best = keys;
+      symmetry = candidate;
+    }
+  }
+
+  return { transform(deal, symmetry), symmetry };
+}
+
+template <typename F>
+static std::vector<Bridge::Result> solveCanonical(std::span<const Bridge::Deal> deals, Bridge::StrainMask mask, const F &solve)
+{
+  using namespace Bridge;
+
+  std::vector<std::pair<Deal, Symmetry>> images(deals.size());
+  std::vector<std::pair<PackedDeal, std::size_t>> keys(deals.size());
+
+  parallelFor(deals.size(), [&](std::size_t i)
+  {
+    images[i] = canonicalize(deals[i], mask);
+    keys[i] = { pack(images[i].first), i };
+  }, 1024);
+
+  std::sort(keys.begin(), keys.end());
+
+  // Solve distinct canonical deals in the order of packed keys
+  std::vector<Deal> distinct;
+  std::vector<std::size_t> indices(deals.size());
+
+  for (std::size_t k = 0; k < keys.size(); ++k) {
+    if (!k || keys[k].first != keys[k - 1].first)
+      distinct.push_back(images[keys[k].second].first);
+
+    indices[keys[k].second] = distinct.size() - 1;
+  }
+
+  const std::vector<Result> solutions = solve(distinct);
+  std::vector<Result> results(deals.size());
+
+  for (std::size_t i = 0; i < deals.size(); ++i)
+    results[i] = transform(solutions[indices[i]], inverse(images[i].second));
+
+  return results;
+}
+
+std::vector<Bridge::Result> Bridge::solveCanonical(std::span<const Bridge::Deal> deals, Bridge::StrainMask mask)
+{
+  return ::solveCanonical(deals, mask, [mask](std::span<const Deal> distinct)
+  {
+    return solve(distinct, mask);
+  });
+}
+
+std::vector<Bridge::Result> Bridge::solveCanonical(std::span<const Bridge::Deal> deals, Bridge::Cache &cache, Bridge::StrainMask mask)
+{
+  return ::solveCanonical(deals, mask, [&cache, mask](std::span<const Deal> distinct)
+  {
+    return solve(distinct, cache, mask);
+  });
+}
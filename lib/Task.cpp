@@ -0,0 +1,166 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Bridge/Task.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <utility>
+
+struct Bridge::Task::State
+{
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<Result> results;
+  std::atomic<std::size_t> progress = 0;
+  bool finished = false;
+  std::exception_ptr error;
+};
+
+// Solve on the calling thread, checking for cancellation between packs
+void Bridge::Task::run(std::stop_token stop, State &state,
+    const Source &source, const Sink &sink, StrainMask mask, const Observer &observer)
+{
+  const auto draw = [&](std::span<Bridge::Deal> buffer) -> std::size_t
+  {
+    return stop.stop_requested() ? 0 : source(buffer);
+  };
+
+  const auto accept = [&](std::span<const Bridge::Deal> deals, std::span<const Bridge::Result> results)
+  {
+    if (stop.stop_requested())
+      return;
+
+    sink(deals, results);
+    state.progress += deals.size();
+  };
+
+  try {
+    Bridge::solve(draw, accept, mask, observer);
+  }
+  catch (...) {
+    const std::lock_guard lock(state.mutex);
+    state.error = std::current_exception();
+  }
+
+  const std::lock_guard lock(state.mutex);
+  state.finished = true;
+  state.changed.notify_all();
+}
+
+Bridge::Task::Task(std::vector<Deal> deals, StrainMask mask, Observer observer):
+  _state(std::make_unique<State>())
+{
+  _thread = std::jthread([&state = *_state, deals = std::move(deals), mask, observer = std::move(observer)](std::stop_token stop)
+  {
+    std::span<const Deal> rest = deals;
+
+    const auto source = [&rest](std::span<Deal> buffer)
+    {
+      const std::size_t size = std::min(buffer.size(), rest.size());
+      std::copy_n(rest.begin(), size, buffer.begin());
+      rest = rest.subspan(size);
+      return size;
+    };
+
+    const auto sink = [&state](std::span<const Deal>, std::span<const Result> results)
+    {
+      const std::lock_guard lock(state.mutex);
+      state.results.insert(state.results.end(), results.begin(), results.end());
+      state.changed.notify_all();
+    };
+
+    run(stop, state, source, sink, mask, observer);
+  });
+}
+
+Bridge::Task::Task(Source source, Sink sink, StrainMask mask, Observer observer):
+  _state(std::make_unique<State>())
+{
+  _thread = std::jthread([&state = *_state, source = std::move(source), sink = std::move(sink), mask, observer = std::move(observer)](std::stop_token stop)
+  {
+    run(stop, state, source, sink, mask, observer);
+  });
+}
+
+Bridge::Task::Task(Task &&) noexcept = default;
+
+// Moving the thread first stops and joins the old one before its state is
+// destroyed
+Bridge::Task &Bridge::Task::operator=(Task &&other) noexcept
+{
+  _thread = std::move(other._thread);
+  _state = std::move(other._state);
+  return *this;
+}
+
+Bridge::Task::~Task()
+{
+  cancel();
+}
+
+std::size_t Bridge::Task::progress() const
+{
+  return _state ? _state->progress.load() : 0;
+}
+
+bool Bridge::Task::done() const
+{
+  if (!_state)
+    return true;
+
+  const std::lock_guard lock(_state->mutex);
+  return _state->finished;
+}
+
+void Bridge::Task::cancel()
+{
+  _thread.request_stop();
+}
+
+void Bridge::Task::wait()
+{
+  if (!_state)
+    return;
+
+  std::unique_lock lock(_state->mutex);
+  _state->changed.wait(lock, [this] { return _state->finished; });
+
+  if (_state->error)
+    std::rethrow_exception(std::exchange(_state->error, nullptr));
+}
+
+std::vector<Bridge::Result> Bridge::Task::take()
+{
+  if (!_state)
+    return {};
+
+  const std::lock_guard lock(_state->mutex);
+  return std::exchange(_state->results, {});
+}
+
+std::vector<Bridge::Result> Bridge::Task::next()
+{
+  if (!_state)
+    return {};
+
+  std::unique_lock lock(_state->mutex);
+  _state->changed.wait(lock, [this] { return _state->finished || !_state->results.empty(); });
+  return std::exchange(_state->results, {});
+}
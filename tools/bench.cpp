@@ -0,0 +1,398 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Bridge/DDS.hpp>
+#include <Bridge/Evaluator.hpp>
+#include <Bridge/Random.hpp>
+#include <Bridge/ResultBatch.hpp>
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <dll.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct Options
+{
+  std::size_t batch;
+  std::size_t samples;
+  std::size_t solveSamples;
+  std::uint64_t seed;
+  std::string filter;
+  bool solve;
+  int threads;
+};
+
+// Results fold into this to defeat dead code elimination
+static volatile std::uint64_t checksum;
+
+// Time run() several times and print a JSON line
+//
+// Latencies are for a whole sample of the given number of deals.  The rate
+// is computed from the median latency.
+template <typename F>
+static void measure(const Options &options, std::size_t samples,
+    std::string_view name, std::string_view parameters, std::size_t deals, const F &run)
+{
+  if (name.find(options.filter) == std::string_view::npos)
+    return;
+
+  using Clock = std::chrono::steady_clock;
+  std::vector<double> latencies(samples);
+
+  run();
+
+  for (double &latency : latencies) {
+    const auto start = Clock::now();
+    run();
+    latency = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+
+  const auto percentile = [&latencies](double p)
+  {
+    return latencies[std::min<std::size_t>(p * latencies.size(), latencies.size() - 1)];
+  };
+
+  std::cout << "{\"benchmark\":\"" << name << '"'
+    << parameters
+    << ",\"deals\":" << deals
+    << ",\"samples\":" << samples
+    << ",\"deals_per_sec\":" << deals * 1e9 / percentile(0.5)
+    << ",\"min_ns\":" << latencies.front()
+    << ",\"p50_ns\":" << percentile(0.5)
+    << ",\"p90_ns\":" << percentile(0.9)
+    << ",\"p99_ns\":" << percentile(0.99)
+    << ",\"max_ns\":" << latencies.back()
+    << "}\n";
+}
+
+static void benchDealing(const Options &options)
+{
+  std::vector<Bridge::Deal> deals(options.batch);
+  Bridge::Philox generator(options.seed);
+
+  measure(options, options.samples, "getRandomDeal", "", deals.size(), [&]
+  {
+    for (Bridge::Deal &deal : deals)
+      deal = Bridge::getRandomDeal();
+
+    checksum = checksum + deals.back()[Bridge::Seat::N][Bridge::Strain::S].bits();
+  });
+
+  measure(options, options.samples, "getRandomDeal/philox", "", deals.size(), [&]
+  {
+    for (Bridge::Deal &deal : deals)
+      deal = Bridge::getRandomDeal(generator);
+
+    checksum = checksum + deals.back()[Bridge::Seat::N][Bridge::Strain::S].bits();
+  });
+
+  measure(options, options.samples, "getRandomDeals", "", deals.size(), [&]
+  {
+    Bridge::getRandomDeals(deals, options.seed);
+    checksum = checksum + deals.back()[Bridge::Seat::N][Bridge::Strain::S].bits();
+  });
+
+  // Preset the first hands of a fixed deal
+  for (int hands = 0; hands < 4; ++hands) {
+    const Bridge::Deal full = Bridge::getRandomDeal(generator);
+    Bridge::Deal preset;
+
+    for (int seat = 0; seat < hands; ++seat)
+      preset[Bridge::Seat(seat)] = full[Bridge::Seat(seat)];
+
+    const std::string parameters = ",\"preset\":" + std::to_string(13 * hands);
+
+    measure(options, options.samples, "fillRandomCards", parameters, deals.size(), [&]
+    {
+      for (Bridge::Deal &deal : deals) {
+        deal = preset;
+        Bridge::fillRandomCards(deal, generator);
+      }
+
+      checksum = checksum + deals.back()[Bridge::Seat::W][Bridge::Strain::S].bits();
+    });
+  }
+}
+
+template <typename F>
+static void benchEvaluator(const Options &options, std::string_view name,
+    std::span<const Bridge::Hand> hands, const F &f)
+{
+  using T = decltype(f(Bridge::Holding()));
+  const Bridge::Table<T> table(f);
+  std::vector<T> points(hands.size());
+
+  measure(options, options.samples, name, ",\"method\":\"direct\"", hands.size(), [&]
+  {
+    for (std::size_t i = 0; i < hands.size(); ++i)
+      points[i] = Bridge::apply(f, hands[i]);
+
+    checksum = checksum + static_cast<std::uint64_t>(points.back());
+  });
+
+  measure(options, options.samples, name, ",\"method\":\"table\"", hands.size(), [&]
+  {
+    table(hands, points);
+    checksum = checksum + static_cast<std::uint64_t>(points.back());
+  });
+}
+
+static void benchEvaluators(const Options &options)
+{
+  std::vector<Bridge::Deal> deals(options.batch);
+  std::vector<Bridge::Hand> hands(options.batch);
+
+  Bridge::getRandomDeals(deals, options.seed);
+
+  for (std::size_t i = 0; i < hands.size(); ++i)
+    hands[i] = deals[i][Bridge::Seat(i % 4)];
+
+  benchEvaluator(options, "HCP", hands, Bridge::HCP);
+  benchEvaluator(options, "BUMRAP", hands, Bridge::BUMRAP);
+  benchEvaluator(options, "Fifths", hands, Bridge::Fifths);
+  benchEvaluator(options, "ltc", hands, Bridge::ltc);
+  benchEvaluator(options, "nltc", hands, Bridge::nltc);
+  benchEvaluator(options, "altc", hands, Bridge::altc);
+}
+
+static void benchConversion(const Options &options)
+{
+  std::vector<Bridge::Deal> deals(options.batch);
+  std::vector<::ddTableDeal> tables(options.batch);
+  std::vector<::ddTableResults> solutions(options.batch);
+  std::vector<Bridge::Result> results(options.batch);
+
+  Bridge::getRandomDeals(deals, options.seed);
+
+  for (std::size_t i = 0; i < solutions.size(); ++i)
+    for (int strain = 0; strain < DDS_STRAINS; ++strain)
+      for (int hand = 0; hand < DDS_HANDS; ++hand)
+        solutions[i].resTable[strain][hand] = (i + strain + hand) % 14;
+
+  measure(options, options.samples, "convertToDDS", "", deals.size(), [&]
+  {
+    for (std::size_t i = 0; i < deals.size(); ++i)
+      tables[i] = Bridge::convertToDDS(deals[i]);
+
+    checksum = checksum + tables.back().cards[0][0];
+  });
+
+  measure(options, options.samples, "Result", "", deals.size(), [&]
+  {
+    for (std::size_t i = 0; i < solutions.size(); ++i)
+      results[i] = Bridge::Result(solutions[i]);
+
+    checksum = checksum + results.back()(Bridge::Strain::N, Bridge::Seat::N);
+  });
+}
+
+// Histograms of tricks over a row-wise vector and a columnar batch
+static void benchHistogram(const Options &options)
+{
+  std::vector<Bridge::Result> results(options.batch);
+  std::vector<std::uint8_t> filter(options.batch);
+  Bridge::Philox generator(options.seed);
+
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    for (int strain = 0; strain < 5; ++strain)
+      for (int seat = 0; seat < 4; ++seat)
+        results[i].set(Bridge::Strain(strain), Bridge::Seat(seat), Bridge::getUniform(generator, 14));
+
+    filter[i] = Bridge::getUniform(generator, 2);
+  }
+
+  const Bridge::ResultBatch batch(results);
+
+  measure(options, options.samples, "histogram", ",\"method\":\"rows\"", results.size(), [&]
+  {
+    Bridge::ResultBatch::Histogram histogram = {};
+
+    for (const Bridge::Result &result : results)
+      ++histogram[result(Bridge::Strain::S, Bridge::Seat::N)];
+
+    checksum = checksum + histogram[10];
+  });
+
+  measure(options, options.samples, "histogram", ",\"method\":\"columns\"", results.size(), [&]
+  {
+    checksum = checksum + batch.histogram(Bridge::Strain::S, Bridge::Seat::N)[10];
+  });
+
+  measure(options, options.samples, "histogram", ",\"method\":\"filtered\"", results.size(), [&]
+  {
+    checksum = checksum + batch.histogram(Bridge::Strain::S, Bridge::Seat::N, filter)[10];
+  });
+}
+
+static void benchSolve(const Options &options)
+{
+  struct Mask
+  {
+    const char *name;
+    Bridge::StrainMask mask;
+  };
+
+  const Mask masks[] = {
+    { "all", {} },
+    { "suits", { 0, 0, 0, 0, 1 } },
+    { "notrump", { 1, 1, 1, 1, 0 } },
+  };
+
+  for (const std::size_t size : { 1, 32, 200, 1000 }) {
+    std::vector<Bridge::Deal> deals(size);
+    Bridge::getRandomDeals(deals, options.seed);
+
+    for (const Mask &mask : masks) {
+      const std::string parameters = ",\"batch\":" + std::to_string(size) + ",\"mask\":\"" + mask.name + '"';
+
+      measure(options, options.solveSamples, "solve", parameters, size, [&]
+      {
+        const std::vector<Bridge::Result> results = Bridge::solve(deals, mask.mask);
+        checksum = checksum + results.back()(Bridge::Strain::N, Bridge::Seat::N);
+      });
+    }
+  }
+
+  // One deal more than a full pack, comparing even packs of a batch with full
+  // packs of a stream
+  for (const Mask &mask : masks) {
+    const Bridge::StrainMask &m = mask.mask;
+    const std::size_t strains = !m.c + !m.d + !m.h + !m.s + !m.n;
+    const std::size_t size = MAXNOOFTABLES * DDS_STRAINS / strains + 1;
+    const std::string parameters = ",\"batch\":" + std::to_string(size) + ",\"mask\":\"" + mask.name + '"';
+
+    std::vector<Bridge::Deal> deals(size);
+    Bridge::getRandomDeals(deals, options.seed);
+
+    measure(options, options.solveSamples, "solve/awkward", parameters, size, [&]
+    {
+      const std::vector<Bridge::Result> results = Bridge::solve(deals, m);
+      checksum = checksum + results.back()(Bridge::Strain::N, Bridge::Seat::N);
+    });
+
+    measure(options, options.solveSamples, "solve/awkward/stream", parameters, size, [&]
+    {
+      std::span<const Bridge::Deal> rest = deals;
+
+      const auto source = [&rest](std::span<Bridge::Deal> buffer)
+      {
+        const std::size_t count = std::min(buffer.size(), rest.size());
+        std::copy_n(rest.begin(), count, buffer.begin());
+        rest = rest.subspan(count);
+        return count;
+      };
+
+      const auto sink = [](std::span<const Bridge::Deal>, std::span<const Bridge::Result> results)
+      {
+        checksum = checksum + results.back()(Bridge::Strain::N, Bridge::Seat::N);
+      };
+
+      Bridge::solve(source, sink, m);
+    });
+  }
+}
+
+// Completions of several partial deals, interleaved as they would come from
+// parallel samplers, comparing caller order with clustered order
+static void benchClustered(const Options &options)
+{
+  const std::size_t partials = 8;
+  const std::size_t size = 1000;
+  std::vector<Bridge::Deal> fixed(partials);
+  std::vector<Bridge::Deal> deals(size);
+
+  Bridge::getRandomDeals(fixed, options.seed);
+
+  for (std::size_t i = 0; i < size; ++i) {
+    deals[i][Bridge::Seat::N] = fixed[i % partials][Bridge::Seat::N];
+    deals[i][Bridge::Seat::S] = fixed[i % partials][Bridge::Seat::S];
+  }
+
+  Bridge::fillRandomCards(deals, options.seed);
+  const std::string parameters = ",\"batch\":" + std::to_string(size) + ",\"partials\":" + std::to_string(partials);
+
+  measure(options, options.solveSamples, "solve/partial", parameters, size, [&]
+  {
+    const std::vector<Bridge::Result> results = Bridge::solve(deals);
+    checksum = checksum + results.back()(Bridge::Strain::N, Bridge::Seat::N);
+  });
+
+  measure(options, options.solveSamples, "solve/partial/clustered", parameters, size, [&]
+  {
+    const std::vector<Bridge::Result> results = Bridge::solveClustered(deals);
+    checksum = checksum + results.back()(Bridge::Strain::N, Bridge::Seat::N);
+  });
+}
+
+int main(int argc, char **argv)
+{
+  const char usage[] = "Usage: bench [options]\n\n"
+    "Benchmark results are printed as JSON lines.\n\n";
+
+  namespace po = boost::program_options;
+  po::options_description desc("Options");
+  Options options;
+
+  desc.add_options()
+    ("help,?", "Display options")
+    ("batch", po::value<std::size_t>(&options.batch)->default_value(4096), "Deals per sample of fast benchmarks")
+    ("samples", po::value<std::size_t>(&options.samples)->default_value(100), "Samples of fast benchmarks")
+    ("solve-samples", po::value<std::size_t>(&options.solveSamples)->default_value(5), "Samples of solver benchmarks")
+    ("seed", po::value<std::uint64_t>(&options.seed)->default_value(0), "Random seed")
+    ("filter", po::value<std::string>(&options.filter), "Only run benchmarks whose names contain this")
+    ("no-solve", "Skip solver benchmarks")
+    ("threads", po::value<int>(&options.threads)->default_value(0), "Threads of DDS, or 0 to let DDS decide");
+
+  try {
+    po::variables_map vars;
+    po::store(po::parse_command_line(argc, argv, desc), vars);
+    po::notify(vars);
+
+    if (vars.count("help")) {
+      std::clog << usage << desc << '\n';
+      return 0;
+    }
+
+    if (!options.batch || !options.samples || !options.solveSamples)
+      throw po::error("batch and samples must be positive");
+
+    options.solve = !vars.count("no-solve");
+  }
+  catch (const po::error &error) {
+    std::clog << "Error: " << error.what() << "\n\n" << usage << desc << '\n';
+    return 1;
+  }
+
+  benchDealing(options);
+  benchEvaluators(options);
+  benchConversion(options);
+  benchHistogram(options);
+
+  if (options.solve) {
+    Bridge::setResources(options.threads);
+    benchSolve(options);
+    benchClustered(options);
+  }
+}
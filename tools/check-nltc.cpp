@@ -15,136 +15,348 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
-#include <Bridge/Evaluator.hpp>
-#include <Bridge/DDS.hpp>
-#include <Eigen/QR>
+#include <Bridge/Cache.hpp>
+#include <Bridge/DealBatch.hpp>
+#include <Bridge/DealFile.hpp>
+#include <Bridge/Random.hpp>
+#include <Bridge/Statistics.hpp>
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/parsers.hpp>
 #include <boost/program_options/positional_options.hpp>
 #include <boost/program_options/variables_map.hpp>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <random>
 
-static int ltc(Bridge::Holding holding)
-{
-  const int length = std::min<int>(holding.size(), 3);
-  return length - __builtin_popcount(holding.bits() >> (15 - length));
-}
+// Tabulated evaluators
+static const Bridge::Table hcpTable(Bridge::addShortness(Bridge::HCP));
+static const Bridge::Table bumrapTable(Bridge::addShortness(Bridge::BUMRAP));
+static const Bridge::Table ltcTable(Bridge::ltc);
+static const Bridge::Table nltcTable(Bridge::nltc);
+static const Bridge::Table altcTable(Bridge::altc);
+
+// Tricks in the best suit contract, followed by evaluations
+const int Features = 6;
+using Observations = Eigen::Matrix<double, Eigen::Dynamic, Features, Eigen::RowMajor>;
 
-static float nltc(Bridge::Holding holding)
+static Observations seatwiseObserve(std::span<const Bridge::Result> solutions, std::span<const Bridge::Deal> deals)
 {
-  const auto length = holding.size();
+  using namespace Bridge;
+
+  assert(solutions.size() == deals.size());
+  const DealBatch batch(deals);
+  Observations result(4 * deals.size(), Features);
+
+  std::vector<int> integers(deals.size());
+  std::vector<float> reals(deals.size());
+
+  const auto evaluate = [&](Seat seat, int feature, const auto &table, auto &points)
+  {
+    batch.evaluate(seat, table, std::span(points));
+
+    for (std::size_t i = 0; i < deals.size(); ++i)
+      result.coeffRef(4 * i + static_cast<int>(seat), feature) = points[i];
+  };
+
+  for (int seat = 0; seat < 4; ++seat) {
+    for (std::size_t i = 0; i < deals.size(); ++i) {
+      result.coeffRef(4 * i + seat, 0) = std::max({
+        solutions[i](Strain::C, Seat(seat)),
+        solutions[i](Strain::D, Seat(seat)),
+        solutions[i](Strain::H, Seat(seat)),
+        solutions[i](Strain::S, Seat(seat)),
+      });
+    }
+
+    evaluate(Seat(seat), 1, hcpTable, integers);
+    evaluate(Seat(seat), 2, bumrapTable, reals);
+    evaluate(Seat(seat), 3, ltcTable, integers);
+    evaluate(Seat(seat), 4, nltcTable, reals);
+    evaluate(Seat(seat), 5, altcTable, reals);
+  }
 
-  return 1.5f * (length >= 1 && !holding.test(14))
-       + 1.0f * (length >= 2 && !holding.test(13))
-       + 0.5f * (length >= 3 && !holding.test(12));
+  return result;
 }
 
-static float altc(Bridge::Holding holding)
+static Observations pairwiseObserve(const Observations &seatwise)
 {
-  return std::min<float>(nltc(holding), holding.size());
+  Observations result(seatwise.rows() / 2, Features);
+
+  for (Eigen::Index i = 0; i < seatwise.rows() / 4; ++i) {
+    result.row(2 * i    ) = seatwise.row(4 * i    ) + seatwise.row(4 * i + 2);
+    result.row(2 * i + 1) = seatwise.row(4 * i + 1) + seatwise.row(4 * i + 3);
+  }
+  return result;
 }
 
-static auto observe(const Bridge::Result &solution, const Bridge::Deal &deal, Bridge::Seat seat)
+static void report(std::ostream &stream, const Bridge::Moments<Features> &seatwise, const Bridge::Moments<Features> &pairwise)
 {
-  using namespace Bridge;
-  Eigen::RowVector<double, 6> vector;
-
-  vector.coeffRef(0) = std::max({
-    solution(Strain::C, seat),
-    solution(Strain::D, seat),
-    solution(Strain::H, seat),
-    solution(Strain::S, seat),
-  });
-
-  const Hand hand = deal[seat];
-  vector.coeffRef(1) = apply(addShortness(HCP), hand);
-  vector.coeffRef(2) = apply(addShortness(BUMRAP), hand);
-  vector.coeffRef(3) = apply(ltc, hand);
-  vector.coeffRef(4) = apply(nltc, hand);
-  vector.coeffRef(5) = apply(altc, hand);
-  return vector;
+  const char header[] = "   Tricks      HCP+  BUM-RAP+       LTC      NLTC      ALTC\n";
+
+  stream << "Seatwise evaluation\n"
+         << header << seatwise.correlation() << "\n\n"
+         << seatwise.regress()
+         << "\n\nPairwise evaluation\n"
+         << header << pairwise.correlation() << "\n\n"
+         << 0.5 * pairwise.regress() << '\n';
 }
 
-static auto seatwiseObserve(std::span<const Bridge::Result> solutions, std::span<const Bridge::Deal> deals)
+struct Options
 {
-  using namespace Bridge;
-  using namespace Eigen;
+  std::size_t number;
+  std::uint64_t seed;
+  std::string cache;
+  std::size_t progress;
+  bool stats;
 
-  assert(solutions.size() == deals.size());
-  const auto Cols = decltype(observe(std::declval<Result>(), {}, Seat::N))::ColsAtCompileTime;
+  // File of deals to analyze instead of random ones
+  std::string input;
 
-  Matrix<double, Dynamic, Cols, RowMajor> result(4 * deals.size(), Cols);
+  // Resources of DDS, where 0 lets DDS decide
+  int threads;
+  int memory;
 
-  for (std::size_t i = 0; i < deals.size(); ++i)
-    for (int seat = 0; seat < 4; ++seat)
-      result.row(4 * i + seat) = observe(solutions[i], deals[i], static_cast<Seat>(seat));
+  // Deals [number * shard / shards, number * (shard + 1) / shards) of the run
+  std::size_t shards;
+  std::size_t shard;
 
-  return result;
+  // Directory of checkpoints, or empty to keep everything in memory
+  std::filesystem::path checkpoint;
+
+  // Merge whatever shards have solved instead of requiring all deals
+  bool partial;
+};
+
+// Progress of a shard, rewritten after every solved pack
+struct Checkpoint
+{
+  std::uint64_t seed;
+  std::uint64_t number;
+  std::uint64_t shards;
+  std::uint64_t shard;
+  std::uint64_t done;
+  Bridge::Moments<Features> seatwise;
+  Bridge::Moments<Features> pairwise;
+};
+
+static const char magic[8] = { 'B', 'r', 'i', 'd', 'g', 'e', 'C', 'K' };
+
+static std::filesystem::path getPath(const Options &options, std::size_t shard, const char *extension)
+{
+  return options.checkpoint / ("shard-" + std::to_string(shard) + extension);
 }
 
-static auto pairwiseObserve(std::span<const Bridge::Result> solutions, std::span<const Bridge::Deal> deals)
+static void write(std::ostream &stream, const Bridge::Moments<Features> &moments)
 {
-  using namespace Bridge;
-  using namespace Eigen;
+  const double weight = moments.weight();
+  stream.write(reinterpret_cast<const char *>(&weight), sizeof(weight));
+  stream.write(reinterpret_cast<const char *>(moments.mean().data()), sizeof(double) * Features);
+  stream.write(reinterpret_cast<const char *>(moments.comoment().data()), sizeof(double) * Features * Features);
+}
 
-  assert(solutions.size() == deals.size());
-  const auto Cols = decltype(observe(std::declval<Result>(), {}, Seat::N))::ColsAtCompileTime;
+static void read(std::istream &stream, Bridge::Moments<Features> &moments)
+{
+  double weight;
+  Bridge::Moments<Features>::Vector mean;
+  Bridge::Moments<Features>::Matrix comoment;
+
+  stream.read(reinterpret_cast<char *>(&weight), sizeof(weight));
+  stream.read(reinterpret_cast<char *>(mean.data()), sizeof(double) * Features);
+  stream.read(reinterpret_cast<char *>(comoment.data()), sizeof(double) * Features * Features);
+  moments.assign(weight, mean, comoment);
+}
 
-  Matrix<double, Dynamic, Cols, RowMajor> result(2 * deals.size(), Cols);
+// Write to a temporary file and rename it, so a crash never leaves a torn file
+static void save(const std::filesystem::path &path, const Checkpoint &checkpoint)
+{
+  std::filesystem::path temporary = path;
+  temporary += ".tmp";
+
+  {
+    std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+    stream.write(magic, sizeof(magic));
+
+    for (const std::uint64_t field : { checkpoint.seed, checkpoint.number, checkpoint.shards, checkpoint.shard, checkpoint.done })
+      stream.write(reinterpret_cast<const char *>(&field), sizeof(field));
 
-  for (std::size_t i = 0; i < deals.size(); ++i) {
-    result.row(2 * i    ) = observe(solutions[i], deals[i], Seat::N) + observe(solutions[i], deals[i], Seat::S);
-    result.row(2 * i + 1) = observe(solutions[i], deals[i], Seat::E) + observe(solutions[i], deals[i], Seat::W);
+    write(stream, checkpoint.seatwise);
+    write(stream, checkpoint.pairwise);
+
+    if (!stream.flush())
+      throw std::runtime_error("Failed to write " + temporary.string());
   }
-  return result;
+
+  std::filesystem::rename(temporary, path);
 }
 
-template <typename Derived>
-static auto corrcoef(const Eigen::MatrixBase<Derived> &observations)
+static Checkpoint load(const std::filesystem::path &path)
 {
-  const auto centered = (observations.rowwise() - observations.colwise().mean()).eval();
-  const auto covariance = ((centered.adjoint() * centered) / (centered.rows() - 1)).eval();
-  const auto diag = covariance.diagonal().array().rsqrt().matrix().eval().asDiagonal();
-  return (diag * covariance * diag).eval();
+  std::ifstream stream(path, std::ios::binary);
+  char header[sizeof(magic)];
+  Checkpoint checkpoint;
+
+  stream.read(header, sizeof(header));
+
+  for (std::uint64_t *field : { &checkpoint.seed, &checkpoint.number, &checkpoint.shards, &checkpoint.shard, &checkpoint.done })
+    stream.read(reinterpret_cast<char *>(field), sizeof(*field));
+
+  read(stream, checkpoint.seatwise);
+  read(stream, checkpoint.pairwise);
+
+  if (!stream || !std::equal(header, header + sizeof(header), magic))
+    throw std::runtime_error("Invalid checkpoint " + path.string());
+
+  return checkpoint;
 }
 
-template <typename Derived>
-static auto regress(const Eigen::MatrixBase<Derived> &observations)
+static void procedure(const Options &options)
 {
-  using namespace Eigen;
-  const auto y = observations.col(0);
-  Matrix<double, 2, Derived::ColsAtCompileTime> beta(2, observations.cols());
+  using namespace Bridge;
+
+  const std::unique_ptr<DealReader> input = options.input.empty() ? nullptr : std::make_unique<DealReader>(options.input);
+  const std::size_t number = input ? input->size() : options.number;
+
+  const std::size_t first = number * options.shard / options.shards;
+  const std::size_t last = number * (options.shard + 1) / options.shards;
+
+  Checkpoint state = { options.seed, number, options.shards, options.shard, 0, Moments<Features>(), Moments<Features>() };
+  const auto statePath = getPath(options, options.shard, ".stats");
+  const auto resultsPath = getPath(options, options.shard, ".results");
+  std::ofstream results;
+
+  // Resume from the checkpoint, dropping results solved after it was saved
+  if (!options.checkpoint.empty()) {
+    std::filesystem::create_directories(options.checkpoint);
+
+    if (std::filesystem::exists(statePath)) {
+      state = load(statePath);
 
-  beta.col(0) << y.mean(), 0;
+      if (state.seed != options.seed || state.number != number || state.shards != options.shards)
+        throw std::runtime_error("Checkpoint " + statePath.string() + " belongs to another run");
 
-  for (typename Derived::Index i = 1; i < observations.cols(); ++i) {
-    Matrix<double, Dynamic, 2> x(y.rows(), 2);
-    x << y.Ones(y.rows()), observations.col(i);
-    beta.col(i) = x.colPivHouseholderQr().solve(y).eval();
+      std::clog << "Resuming shard " << options.shard << " after " << state.done << " deals\n";
+    }
+
+    std::ofstream(resultsPath, std::ios::binary | std::ios::app);
+    std::filesystem::resize_file(resultsPath, state.done * sizeof(PackedResult));
+    results.open(resultsPath, std::ios::binary | std::ios::app);
   }
-  return beta;
+
+  std::size_t produced = first + state.done;
+
+  const auto random = [&](std::span<Deal> buffer)
+  {
+    const std::size_t size = std::min(buffer.size(), last - produced);
+    getRandomDeals(buffer.first(size), options.seed, produced);
+    produced += size;
+    return size;
+  };
+
+  const Source source = input ? input->source(produced, last) : Source(random);
+
+  // Extract features while DDS is solving the next pack
+  const auto sink = [&](std::span<const Deal> deals, std::span<const Result> solutions)
+  {
+    const Observations observations = seatwiseObserve(solutions, deals);
+    state.seatwise.merge(Moments<Features>(observations));
+    state.pairwise.merge(Moments<Features>(pairwiseObserve(observations)));
+
+    const std::size_t done = state.done;
+    state.done += deals.size();
+
+    if (results.is_open()) {
+      for (const Result &solution : solutions) {
+        const PackedResult packed = pack(solution);
+        results.write(reinterpret_cast<const char *>(packed.data()), packed.size());
+      }
+
+      if (!results.flush())
+        throw std::runtime_error("Failed to write " + resultsPath.string());
+
+      save(statePath, state);
+    }
+
+    if (options.progress && state.done / options.progress > done / options.progress) {
+      std::clog << "After " << state.done << " deals\n";
+      report(std::clog, state.seatwise, state.pairwise);
+      std::clog << std::endl;
+    }
+  };
+
+  // Filter out notrump contracts
+  const StrainMask mask = { false, false, false, false, /*.n=*/true };
+
+  setResources(options.threads, options.memory);
+
+  SolveStats stats;
+  const auto observer = [&stats](const PackStats &pack) { stats += pack; };
+
+  if (options.cache.empty()) {
+    solve(source, sink, mask, observer);
+  }
+  else {
+    Cache cache(options.cache);
+    solve(source, sink, cache, mask, observer);
+  }
+
+  report(std::cout, state.seatwise, state.pairwise);
+
+  if (options.stats)
+    std::clog << '\n' << stats;
 }
 
-static void procedure(std::size_t number)
+// Combine checkpoints of all shards in the directory, throwing on missing or
+// unfinished shards unless partial results are asked for
+static void merge(const Options &options)
 {
-  std::vector<Bridge::Deal> deals;
-  deals.reserve(number);
-  std::generate_n(std::back_inserter(deals), number, Bridge::getRandomDeal);
+  Bridge::Moments<Features> seatwise;
+  Bridge::Moments<Features> pairwise;
+  std::size_t shards = 0;
+  std::size_t done = 0;
+  std::size_t number = 0;
+  std::uint64_t seed = 0;
+
+  for (std::size_t shard = 0; !shards || shard < shards; ++shard) {
+    const auto path = getPath(options, shard, ".stats");
+
+    // Shard 0 tells how many shards there are
+    if (!std::filesystem::exists(path)) {
+      if (!shards || !options.partial)
+        throw std::runtime_error("Missing checkpoint " + path.string());
+
+      std::clog << "Missing shard " << shard << '\n';
+      continue;
+    }
 
-  // Filter out notrump contracts
-  const Bridge::StrainMask mask = { false, false, false, false, /*.n=*/true };
-  const auto solutions = Bridge::solve(deals, mask);
-  const char header[] = "   Tricks      HCP+  BUM-RAP+       LTC      NLTC      ALTC\n";
+    const Checkpoint checkpoint = load(path);
+
+    if (!shards) {
+      shards = checkpoint.shards;
+      number = checkpoint.number;
+      seed = checkpoint.seed;
+    }
+    else if (checkpoint.shards != shards || checkpoint.number != number || checkpoint.seed != seed) {
+      throw std::runtime_error("Checkpoint " + path.string() + " belongs to another run");
+    }
+
+    const std::size_t size = number * (shard + 1) / shards - number * shard / shards;
 
-  const auto seatwise = seatwiseObserve(solutions, deals);
-  const auto pairwise = pairwiseObserve(solutions, deals);
+    if (checkpoint.done < size) {
+      if (!options.partial)
+        throw std::runtime_error("Shard " + std::to_string(shard) + " has solved only "
+          + std::to_string(checkpoint.done) + " of " + std::to_string(size) + " deals");
 
-  std::cout << "Seatwise evaluation\n"
-            << header << corrcoef(seatwise) << "\n\n"
-            << regress(seatwise)
-            << "\n\nPairwise evaluation\n"
-            << header << corrcoef(pairwiseObserve(solutions, deals)) << "\n\n"
-            << 0.5 * regress(pairwise) << '\n';
+      std::clog << "Unfinished shard " << shard << ": " << checkpoint.done << " of " << size << " deals\n";
+    }
+
+    seatwise.merge(checkpoint.seatwise);
+    pairwise.merge(checkpoint.pairwise);
+    done += checkpoint.done;
+  }
+
+  std::clog << "Merged " << done << " of " << number << " deals in " << shards << " shards\n";
+  report(std::cout, seatwise, pairwise);
 }
 
 int main(int argc, char **argv)
@@ -154,11 +366,24 @@ int main(int argc, char **argv)
 
   namespace po = boost::program_options;
   po::options_description desc("Options");
-  std::size_t number;
+  Options options;
+  std::string checkpoint;
 
   desc.add_options()
     ("help,?", "Display options")
-    ("number", po::value<std::size_t>(&number)->default_value(100), "Number of deals");
+    ("number", po::value<std::size_t>(&options.number)->default_value(100), "Number of deals")
+    ("seed", po::value<std::uint64_t>(&options.seed), "Random seed for reproducible runs")
+    ("input", po::value<std::string>(&options.input), "Analyze deals from a binary deal file or PBN/LIN text")
+    ("cache", po::value<std::string>(&options.cache), "File of cached double-dummy results")
+    ("progress", po::value<std::size_t>(&options.progress)->default_value(0), "Report intermediate results every this many deals")
+    ("threads", po::value<int>(&options.threads)->default_value(0), "Threads of DDS, or 0 to let DDS decide")
+    ("memory", po::value<int>(&options.memory)->default_value(0), "Memory of DDS in MB, or 0 to let DDS decide")
+    ("stats", po::bool_switch(&options.stats), "Report solver statistics at the end")
+    ("shards", po::value<std::size_t>(&options.shards)->default_value(1), "Number of shards to split the run into")
+    ("shard", po::value<std::size_t>(&options.shard)->default_value(0), "Index of the shard to run")
+    ("checkpoint", po::value<std::string>(&checkpoint), "Directory to save and resume shard progress")
+    ("merge", "Combine checkpoints of all shards instead of solving")
+    ("partial", po::bool_switch(&options.partial), "Merge missing or unfinished shards without failing");
 
   po::positional_options_description pos;
   pos.add("number", 1);
@@ -173,10 +398,38 @@ int main(int argc, char **argv)
       return 0;
     }
 
-    procedure(number);
+    options.checkpoint = checkpoint;
+
+    if (vars.count("merge")) {
+      if (checkpoint.empty())
+        throw po::required_option("checkpoint");
+
+      merge(options);
+      return 0;
+    }
+
+    if (options.shard >= options.shards)
+      throw po::invalid_option_value(std::to_string(options.shard));
+
+    // Shards must agree on the deals
+    if (!options.input.empty()) {
+      options.seed = 0;
+    }
+    else if (!vars.count("seed")) {
+      if (options.shards > 1 || !checkpoint.empty())
+        throw po::required_option("seed");
+
+      options.seed = static_cast<std::uint64_t>(std::random_device{}()) << 32 | std::random_device{}();
+    }
+
+    procedure(options);
   }
   catch (const po::error &error) {
     std::clog << "Error: " << error.what() << "\n\n" << usage << desc << '\n';
     return 1;
   }
+  catch (const std::exception &error) {
+    std::clog << "Error: " << error.what() << '\n';
+    return 1;
+  }
 }
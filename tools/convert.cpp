@@ -0,0 +1,111 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Bridge/DealFile.hpp>
+#include <Bridge/Notation.hpp>
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/positional_options.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+static void procedure(const std::string &input, const std::string &output)
+{
+  using namespace Bridge;
+
+  const auto start = std::chrono::steady_clock::now();
+  const DealReader reader(input);
+  const std::size_t size = reader.size();
+  const Source source = reader.source();
+  std::vector<Deal> deals(4096);
+
+  if (std::filesystem::path(output).extension() == ".bin") {
+    DealWriter writer(output);
+
+    while (const std::size_t count = source(deals))
+      writer.write(std::span(deals).first(count));
+
+    writer.flush();
+  }
+  else {
+    std::ofstream stream(output, std::ios::binary | std::ios::trunc);
+    std::vector<char> buffer(deals.size() * 70);
+
+    while (const std::size_t count = source(deals)) {
+      char *cursor = buffer.data();
+
+      for (std::size_t i = 0; i < count; ++i) {
+        cursor = formatPBN(cursor, buffer.data() + buffer.size(), deals[i]).ptr;
+        *cursor++ = '\n';
+      }
+
+      stream.write(buffer.data(), cursor - buffer.data());
+    }
+
+    if (!stream.flush())
+      throw std::runtime_error("Cannot write " + output);
+  }
+
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  std::clog << "Converted " << size << " deals in " << elapsed.count() << " s ("
+            << size / elapsed.count() << " deals/sec)\n";
+}
+
+int main(int argc, char **argv)
+{
+  const char usage[] = "Usage: convert [options] input output\n\n"
+    "Files ending in .bin are binary deal files.  Other input files are text\n"
+    "with PBN or LIN deals, one per line, and other output files are bare PBN.\n\n";
+
+  namespace po = boost::program_options;
+  po::options_description desc("Options");
+  std::string input;
+  std::string output;
+
+  desc.add_options()
+    ("help,?", "Display options")
+    ("input", po::value<std::string>(&input)->required(), "Input file")
+    ("output", po::value<std::string>(&output)->required(), "Output file");
+
+  po::positional_options_description pos;
+  pos.add("input", 1);
+  pos.add("output", 1);
+
+  try {
+    po::variables_map vars;
+    po::store(po::command_line_parser(argc, argv).options(desc).positional(pos).run(), vars);
+
+    if (vars.count("help")) {
+      std::clog << usage << desc << '\n';
+      return 0;
+    }
+
+    po::notify(vars);
+    procedure(input, output);
+  }
+  catch (const po::error &error) {
+    std::clog << "Error: " << error.what() << "\n\n" << usage << desc << '\n';
+    return 1;
+  }
+  catch (const std::exception &error) {
+    std::clog << "Error: " << error.what() << '\n';
+    return 1;
+  }
+}
@@ -0,0 +1,195 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Bridge/DealFile.hpp>
+#include <Bridge/Dealer.hpp>
+#include <Bridge/Random.hpp>
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/positional_options.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <charconv>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string_view>
+
+// Parse "a", "a+", or "a-b"
+static Bridge::Range parseRange(std::string_view text, int max)
+{
+  namespace po = boost::program_options;
+  Bridge::Range range;
+  const char *last = text.data() + text.size();
+  auto [end, error] = std::from_chars(text.data(), last, range.min);
+
+  if (error != std::errc())
+    throw po::invalid_option_value(std::string(text));
+
+  if (end == last)
+    range.max = range.min;
+  else if (*end == '+' && end + 1 == last)
+    range.max = max;
+  else if (*end != '-' || std::from_chars(end + 1, last, range.max).ptr != last)
+    throw po::invalid_option_value(std::string(text));
+
+  return range;
+}
+
+// Parse comma-separated terms like "hcp=15-17,s=5+,balanced"
+static Bridge::Constraint parseConstraint(std::string_view text)
+{
+  namespace po = boost::program_options;
+  Bridge::Constraint constraint;
+
+  while (!text.empty()) {
+    const auto comma = std::min(text.find(','), text.size());
+    const std::string_view term = text.substr(0, comma);
+    const auto equal = term.find('=');
+    const std::string_view key = term.substr(0, equal);
+    const std::string_view value = equal == term.npos ? std::string_view() : term.substr(equal + 1);
+
+    if (key == "balanced" && equal == term.npos)
+      constraint.shape = Bridge::isBalanced;
+    else if (key == "hcp")
+      constraint.hcp = parseRange(value, 37);
+    else if (key == "c" || key == "d" || key == "h" || key == "s")
+      constraint.lengths[std::string_view("cdhs").find(key)] = parseRange(value, 13);
+    else
+      throw po::invalid_option_value(std::string(term));
+
+    text.remove_prefix(std::min(comma + 1, text.size()));
+  }
+
+  return constraint;
+}
+
+static void procedure(const Bridge::Dealer &dealer, std::size_t number, std::uint64_t seed,
+    bool reject, bool quiet, const std::string &output)
+{
+  using namespace Bridge;
+
+  std::vector<Deal> deals(number);
+  std::size_t tries = 0;
+  double baseline = 0;
+
+  if (reject) {
+    // Time the shape-first dealer on one thread too, as rejection is serial
+    const auto start = std::chrono::steady_clock::now();
+
+    for (std::size_t i = 0; i < number; ++i) {
+      Philox generator(seed, i);
+      deals[i] = dealer(generator);
+    }
+
+    baseline = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+
+  if (reject) {
+    Philox generator(seed);
+
+    for (Deal &deal : deals)
+      do {
+        deal = getRandomDeal(generator);
+        ++tries;
+      } while (!dealer.accepts(deal));
+  }
+  else {
+    dealer(deals, seed);
+  }
+
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  if (!output.empty()) {
+    DealWriter writer(output);
+    writer.write(deals);
+    writer.flush();
+  }
+  else if (!quiet) {
+    for (const Deal &deal : deals)
+      std::cout << deal << '\n';
+  }
+
+  std::clog << "Dealt " << number << " deals in " << elapsed.count() << " s ("
+            << number / elapsed.count() << " deals/sec)\n"
+            << "Shape probability: " << dealer.probability() << '\n';
+
+  if (reject)
+    std::clog << "Acceptance rate: " << static_cast<double>(number) / tries << '\n'
+              << "Shape-first on one thread: " << number / baseline << " deals/sec\n";
+}
+
+int main(int argc, char **argv)
+{
+  const char usage[] = "Usage: deal [options] [number]\n\n"
+    "Constraints are comma-separated terms like \"hcp=15-17,s=5+,balanced\",\n"
+    "where c, d, h, s are suit lengths.\n\n";
+
+  std::ios_base::sync_with_stdio(false);
+
+  namespace po = boost::program_options;
+  po::options_description desc("Options");
+  std::size_t number;
+  std::uint64_t seed;
+  std::string specs[4];
+  std::string output;
+
+  desc.add_options()
+    ("help,?", "Display options")
+    ("number", po::value<std::size_t>(&number)->default_value(10), "Number of deals")
+    ("north,N", po::value<std::string>(&specs[0]), "Constraint on North")
+    ("east,E", po::value<std::string>(&specs[1]), "Constraint on East")
+    ("south,S", po::value<std::string>(&specs[2]), "Constraint on South")
+    ("west,W", po::value<std::string>(&specs[3]), "Constraint on West")
+    ("seed", po::value<std::uint64_t>(&seed), "Random seed for reproducible runs")
+    ("reject", "Use naive rejection sampling for comparison")
+    ("quiet,q", "Only report throughput")
+    ("output,o", po::value<std::string>(&output), "Write deals to a binary deal file");
+
+  po::positional_options_description pos;
+  pos.add("number", 1);
+
+  try {
+    po::variables_map vars;
+    po::store(po::command_line_parser(argc, argv).options(desc).positional(pos).run(), vars);
+    po::notify(vars);
+
+    if (vars.count("help")) {
+      std::clog << usage << desc << '\n';
+      return 0;
+    }
+
+    if (!vars.count("seed"))
+      seed = static_cast<std::uint64_t>(std::random_device{}()) << 32 | std::random_device{}();
+
+    std::array<Bridge::Constraint, 4> constraints;
+
+    for (int seat = 0; seat < 4; ++seat)
+      constraints[seat] = parseConstraint(specs[seat]);
+
+    procedure(Bridge::Dealer(constraints), number, seed, vars.count("reject"), vars.count("quiet"), output);
+  }
+  catch (const po::error &error) {
+    std::clog << "Error: " << error.what() << "\n\n" << usage << desc << '\n';
+    return 1;
+  }
+  catch (const std::exception &error) {
+    std::clog << "Error: " << error.what() << '\n';
+    return 1;
+  }
+}
@@ -0,0 +1,126 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Bridge/Distribution.hpp>
+#include <Bridge/Evaluator.hpp>
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/positional_options.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <iostream>
+#include <memory>
+
+using Values = Bridge::Table<double>;
+
+// Tabulate a named evaluator
+static std::unique_ptr<Values> getValues(const std::string &name, bool shortness)
+{
+  namespace po = boost::program_options;
+
+  const auto make = [shortness](const auto &f)
+  {
+    return shortness ? std::make_unique<Values>(Bridge::addShortness(f)) : std::make_unique<Values>(f);
+  };
+
+  if (name == "hcp")
+    return make(Bridge::HCP);
+  if (name == "bumrap")
+    return make(Bridge::BUMRAP);
+  if (name == "fifths")
+    return make(Bridge::Fifths);
+  if (name == "ltc")
+    return make(Bridge::ltc);
+  if (name == "nltc")
+    return make(Bridge::nltc);
+  if (name == "altc")
+    return make(Bridge::altc);
+
+  throw po::invalid_option_value(name);
+}
+
+static void procedure(const Values &values, const Values *versus, int hands)
+{
+  if (versus) {
+    const Bridge::Distribution joint([&](Bridge::Holding holding)
+    {
+      return std::pair(values(holding), (*versus)(holding));
+    }, hands);
+
+    for (const auto &[value, count] : joint.counts())
+      std::cout << value.first << '\t' << value.second << '\t' << joint.probability(value) << '\n';
+
+    return;
+  }
+
+  const Bridge::Distribution distribution([&values](Bridge::Holding holding) { return values(holding); }, hands);
+  double cumulative = 0;
+
+  std::cout << "# Mean " << distribution.mean() << ", standard deviation " << distribution.stddev() << '\n';
+
+  for (const auto &[value, count] : distribution.counts()) {
+    const double probability = distribution.probability(value);
+    cumulative += probability;
+    std::cout << value << '\t' << probability << '\t' << cumulative << '\n';
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const char usage[] = "Usage: distribution [options] evaluator\n\n"
+    "Print the exact distribution of an evaluator over all hands.  Evaluators\n"
+    "are hcp, bumrap, fifths, ltc, nltc, and altc.\n\n";
+
+  namespace po = boost::program_options;
+  po::options_description desc("Options");
+  std::string evaluator;
+  std::string versus;
+  bool shortness;
+  bool partnership;
+
+  desc.add_options()
+    ("help,?", "Display options")
+    ("evaluator", po::value<std::string>(&evaluator)->default_value("hcp"), "Evaluator to tabulate")
+    ("versus", po::value<std::string>(&versus), "Print the joint distribution with another evaluator")
+    ("shortness", po::bool_switch(&shortness), "Add points for short suits")
+    ("partnership", po::bool_switch(&partnership), "Evaluate the combined hands of a partnership");
+
+  po::positional_options_description pos;
+  pos.add("evaluator", 1);
+
+  try {
+    po::variables_map vars;
+    po::store(po::command_line_parser(argc, argv).options(desc).positional(pos).run(), vars);
+    po::notify(vars);
+
+    if (vars.count("help")) {
+      std::clog << usage << desc << '\n';
+      return 0;
+    }
+
+    const auto values = getValues(evaluator, shortness);
+    const auto other = versus.empty() ? nullptr : getValues(versus, shortness);
+    procedure(*values, other.get(), 1 + partnership);
+  }
+  catch (const po::error &error) {
+    std::clog << "Error: " << error.what() << "\n\n" << usage << desc << '\n';
+    return 1;
+  }
+  catch (const std::exception &error) {
+    std::clog << "Error: " << error.what() << '\n';
+    return 1;
+  }
+}
@@ -0,0 +1,279 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Bridge/Cache.hpp>
+#include <Bridge/DealFile.hpp>
+#include <Bridge/Random.hpp>
+#include <Bridge/Statistics.hpp>
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/positional_options.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+struct Options
+{
+  std::size_t number;
+  std::uint64_t seed;
+  std::string input;
+  std::string cache;
+  bool notrump;
+
+  // Count the top this many ranks, and short suits unless disabled
+  int ranks;
+  bool shortness;
+
+  // Resources of DDS, where 0 lets DDS decide
+  int threads;
+  int memory;
+};
+
+// Tricks followed by counts of the top ranks and of voids, singletons, and
+// doubletons
+//
+// Observations of a chunk are transient: only their moments are kept, so
+// memory does not grow with the number of deals.
+using Observations = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+static Eigen::Index getFeatures(const Options &options)
+{
+  return 1 + options.ranks + 3 * options.shortness;
+}
+
+static int getTricks(const Options &options, const Bridge::Result &result, Bridge::Seat seat)
+{
+  using Bridge::Strain;
+
+  if (options.notrump)
+    return result(Strain::N, seat);
+
+  return std::max({ result(Strain::C, seat), result(Strain::D, seat), result(Strain::H, seat), result(Strain::S, seat) });
+}
+
+static void addFeatures(const Options &options, const Bridge::Hand &hand, Observations::RowXpr row)
+{
+  for (int suit = 0; suit < 4; ++suit) {
+    const Bridge::Holding holding = hand[Bridge::Strain(suit)];
+
+    for (int i = 0; i < options.ranks; ++i)
+      row(1 + i) += holding.test(14 - i);
+
+    if (options.shortness && holding.size() < 3)
+      row(1 + options.ranks + holding.size()) += 1;
+  }
+}
+
+using Fit = std::pair<Bridge::Moments<>, Bridge::Moments<>>;
+
+// Seatwise and pairwise moments of a chunk
+//
+// A partnership takes the tricks of its better declarer and the sum of the
+// features of both hands.
+static Fit observe(const Options &options, std::span<const Bridge::Deal> deals, std::span<const Bridge::Result> results)
+{
+  const Eigen::Index features = getFeatures(options);
+  Observations seatwise = Observations::Zero(4 * deals.size(), features);
+  Observations pairwise(2 * deals.size(), features);
+
+  for (std::size_t i = 0; i < deals.size(); ++i) {
+    for (int seat = 0; seat < 4; ++seat) {
+      auto row = seatwise.row(4 * i + seat);
+      row(0) = getTricks(options, results[i], Bridge::Seat(seat));
+      addFeatures(options, deals[i][Bridge::Seat(seat)], row);
+    }
+
+    for (int pair = 0; pair < 2; ++pair) {
+      pairwise.row(2 * i + pair) = seatwise.row(4 * i + pair) + seatwise.row(4 * i + pair + 2);
+      pairwise(2 * i + pair, 0) = std::max(seatwise(4 * i + pair, 0), seatwise(4 * i + pair + 2, 0));
+    }
+  }
+
+  return { Bridge::Moments<>(seatwise), Bridge::Moments<>(pairwise) };
+}
+
+// Observe chunks of a pack in parallel and merge their moments
+static void accumulate(const Options &options, std::span<const Bridge::Deal> deals, std::span<const Bridge::Result> results, Fit &fit)
+{
+  const std::size_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+  const std::size_t chunk = std::max<std::size_t>((deals.size() + cores - 1) / cores, 1024);
+  std::vector<std::future<Fit>> futures;
+
+  for (std::size_t begin = 0; begin < deals.size(); begin += chunk) {
+    const std::size_t size = std::min(chunk, deals.size() - begin);
+
+    futures.push_back(std::async(std::launch::async, observe, std::cref(options),
+        deals.subspan(begin, size), results.subspan(begin, size)));
+  }
+
+  for (auto &future : futures) {
+    const Fit part = future.get();
+    fit.first.merge(part.first);
+    fit.second.merge(part.second);
+  }
+}
+
+static void report(std::ostream &stream, const char *title, const Options &options, const Bridge::Moments<> &moments)
+{
+  static const char *const ranks[] = { "A", "K", "Q", "J", "T", "9", "8", "7", "6", "5", "4", "3" };
+  static const char *const lengths[] = { "Void", "Singleton", "Doubleton" };
+
+  const Eigen::VectorXd beta = moments.fit();
+  const Eigen::Index n = moments.size() - 1;
+  const double explained = beta.tail(n).dot(moments.comoment().col(0).tail(n)) / moments.comoment()(0, 0);
+
+  // Points scaled so that an ace counts 4, comparable to HCP
+  const double scale = options.ranks ? 4 / beta(1) : 1;
+
+  stream << std::fixed << std::setprecision(4)
+         << title << " fit over " << std::size_t(moments.weight()) << " observations, R^2 = " << explained << '\n'
+         << "   Feature    Tricks    Points\n"
+         << std::setw(10) << "Intercept" << std::setw(10) << beta(0) << '\n';
+
+  for (Eigen::Index i = 1; i <= n; ++i) {
+    const char *name = i <= options.ranks ? ranks[i - 1] : lengths[i - 1 - options.ranks];
+    stream << std::setw(10) << name << std::setw(10) << beta(i) << std::setw(10) << scale * beta(i) << '\n';
+  }
+
+  stream << std::defaultfloat;
+}
+
+static void procedure(const Options &options)
+{
+  using namespace Bridge;
+
+  const Eigen::Index features = getFeatures(options);
+  Fit fit { Moments<>(features), Moments<>(features) };
+
+  const std::unique_ptr<DealReader> input = options.input.empty() ? nullptr : std::make_unique<DealReader>(options.input);
+  const std::size_t number = input ? input->size() : options.number;
+  const DealFile *binary = input ? input->binary() : nullptr;
+
+  // Stored results need no solving
+  if (binary && binary->hasResults()) {
+    const std::size_t pack = 1 << 16;
+    std::vector<Deal> deals;
+    std::vector<Result> results;
+
+    for (std::size_t begin = 0; begin < number; begin += pack) {
+      const std::size_t end = std::min(begin + pack, number);
+      deals.resize(end - begin);
+      results.resize(end - begin);
+
+      for (std::size_t i = begin; i < end; ++i) {
+        deals[i - begin] = (*binary)[i];
+        results[i - begin] = binary->result(i);
+      }
+
+      accumulate(options, deals, results, fit);
+    }
+  }
+  else {
+    std::size_t produced = 0;
+
+    const auto random = [&](std::span<Deal> buffer)
+    {
+      const std::size_t size = std::min(buffer.size(), number - produced);
+      getRandomDeals(buffer.first(size), options.seed, produced);
+      produced += size;
+      return size;
+    };
+
+    const Source source = input ? input->source() : Source(random);
+
+    const auto sink = [&](std::span<const Deal> deals, std::span<const Result> results)
+    {
+      accumulate(options, deals, results, fit);
+    };
+
+    // Solve only the strains to fit
+    const StrainMask mask = options.notrump
+      ? StrainMask{ true, true, true, true, false }
+      : StrainMask{ false, false, false, false, true };
+
+    setResources(options.threads, options.memory);
+
+    if (options.cache.empty()) {
+      solve(source, sink, mask);
+    }
+    else {
+      Cache cache(options.cache);
+      solve(source, sink, cache, mask);
+    }
+  }
+
+  report(std::cout, "Seatwise", options, fit.first);
+  std::cout << '\n';
+  report(std::cout, "Pairwise", options, fit.second);
+}
+
+int main(int argc, char **argv)
+{
+  const char usage[] = "Usage: fit-evaluator [options] [number]\n\n";
+  std::ios_base::sync_with_stdio(false);
+
+  namespace po = boost::program_options;
+  po::options_description desc("Options");
+  Options options;
+  bool noShortness;
+
+  desc.add_options()
+    ("help,?", "Display options")
+    ("number", po::value<std::size_t>(&options.number)->default_value(100), "Number of random deals")
+    ("seed", po::value<std::uint64_t>(&options.seed), "Random seed for reproducible runs")
+    ("input", po::value<std::string>(&options.input), "Fit deals from a binary deal file or PBN/LIN text")
+    ("cache", po::value<std::string>(&options.cache), "File of cached double-dummy results")
+    ("ranks", po::value<int>(&options.ranks)->default_value(5), "Number of top ranks to value, at most 12")
+    ("no-shortness", po::bool_switch(&noShortness), "Do not value voids, singletons, and doubletons")
+    ("notrump", po::bool_switch(&options.notrump), "Fit notrump tricks instead of the best suit")
+    ("threads", po::value<int>(&options.threads)->default_value(0), "Threads of DDS, or 0 to let DDS decide")
+    ("memory", po::value<int>(&options.memory)->default_value(0), "Memory of DDS in MB, or 0 to let DDS decide");
+
+  po::positional_options_description pos;
+  pos.add("number", 1);
+
+  try {
+    po::variables_map vars;
+    po::store(po::command_line_parser(argc, argv).options(desc).positional(pos).run(), vars);
+    po::notify(vars);
+
+    if (vars.count("help")) {
+      std::clog << usage << desc << '\n';
+      return 0;
+    }
+
+    // All 13 ranks always sum to 13 cards, collinear with the intercept
+    if (options.ranks < 0 || options.ranks > 12)
+      throw po::invalid_option_value(std::to_string(options.ranks));
+
+    if (!vars.count("seed"))
+      options.seed = static_cast<std::uint64_t>(std::random_device{}()) << 32 | std::random_device{}();
+
+    options.shortness = !noShortness;
+    procedure(options);
+  }
+  catch (const po::error &error) {
+    std::clog << "Error: " << error.what() << "\n\n" << usage << desc << '\n';
+    return 1;
+  }
+  catch (const std::exception &error) {
+    std::clog << "Error: " << error.what() << '\n';
+    return 1;
+  }
+}
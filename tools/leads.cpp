@@ -0,0 +1,138 @@
+// This file is part of Bridge, a library and utility for bridge.
+//
+// Copyright (C) 2022 Chen-Pang He <https://jdh8.org/>
+//
+// Bridge is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bridge is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Bridge/Notation.hpp>
+#include <Bridge/SingleDummy.hpp>
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/positional_options.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string_view>
+
+// Parse a contract like "3N" or "4SX"
+static Bridge::Contract parseContract(std::string_view text, std::string_view declarer)
+{
+  namespace po = boost::program_options;
+  const std::string_view strains = "CDHSN";
+  const std::string_view seats = "NESW";
+  Bridge::Contract contract;
+
+  if (text.size() < 2 || text.size() > 3 || text[0] < '1' || text[0] > '7'
+      || strains.find(text[1]) == text.npos || (text.size() == 3 && text[2] != 'X'))
+    throw po::invalid_option_value(std::string(text));
+
+  if (declarer.size() != 1 || seats.find(declarer[0]) == declarer.npos)
+    throw po::invalid_option_value(std::string(declarer));
+
+  contract.level = text[0] - '0';
+  contract.strain = Bridge::Strain(strains.find(text[1]));
+  contract.declarer = Bridge::Seat(seats.find(declarer[0]));
+  contract.doubled = text.size() == 3;
+  return contract;
+}
+
+static void procedure(const Bridge::Deal &partial, const Bridge::Contract &contract, std::size_t number, std::uint64_t seed)
+{
+  using namespace Bridge;
+
+  const LeadAnalysis analysis = analyzeLeads(partial, contract, number, seed);
+  std::vector<int> cards;
+
+  for (int card = 0; card < 52; ++card)
+    if (analysis.weights[card])
+      cards.push_back(card);
+
+  // Best leads for the defenders first
+  std::stable_sort(cards.begin(), cards.end(), [&analysis](int x, int y)
+  {
+    return analysis.sets[x] / analysis.weights[x] > analysis.sets[y] / analysis.weights[y];
+  });
+
+  std::cout << "Lead    Tricks    Defeat\n" << std::fixed << std::setprecision(4);
+
+  for (const int card : cards) {
+    const Strain suit = Strain(card / 13);
+    const int rank = card % 13 + 2;
+
+    std::cout << ' ' << "CDHS"[card / 13] << "23456789TJQKA"[card % 13] << "  "
+              << std::setw(8) << analysis.mean(suit, rank)
+              << std::setw(10) << analysis.probability(suit, rank) << '\n';
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const char usage[] = "Usage: leads [options] deal\n\n"
+    "Rank opening leads over random completions of a PBN deal, where \"-\"\n"
+    "stands for an unknown hand, e.g. \"N:- KQT2.AT.J6542.85 - -\".\n\n";
+
+  namespace po = boost::program_options;
+  po::options_description desc("Options");
+  std::string deal;
+  std::string contract;
+  std::string declarer;
+  std::size_t number;
+  std::uint64_t seed;
+
+  desc.add_options()
+    ("help,?", "Display options")
+    ("deal", po::value<std::string>(&deal), "Partial deal in PBN")
+    ("contract", po::value<std::string>(&contract)->default_value("3N"), "Contract like 3N or 4SX")
+    ("declarer", po::value<std::string>(&declarer)->default_value("S"), "Seat of declarer")
+    ("number", po::value<std::size_t>(&number)->default_value(1000), "Number of deals")
+    ("seed", po::value<std::uint64_t>(&seed), "Random seed for reproducible runs");
+
+  po::positional_options_description pos;
+  pos.add("deal", 1);
+
+  try {
+    po::variables_map vars;
+    po::store(po::command_line_parser(argc, argv).options(desc).positional(pos).run(), vars);
+    po::notify(vars);
+
+    if (vars.count("help")) {
+      std::clog << usage << desc << '\n';
+      return 0;
+    }
+
+    if (!vars.count("deal"))
+      throw po::required_option("deal");
+
+    Bridge::Deal partial;
+    const auto result = Bridge::parsePBN(deal.data(), deal.data() + deal.size(), partial);
+
+    if (result.ec != std::errc() || result.ptr != deal.data() + deal.size())
+      throw po::invalid_option_value(deal);
+
+    if (!vars.count("seed"))
+      seed = static_cast<std::uint64_t>(std::random_device{}()) << 32 | std::random_device{}();
+
+    procedure(partial, parseContract(contract, declarer), number, seed);
+  }
+  catch (const po::error &error) {
+    std::clog << "Error: " << error.what() << "\n\n" << usage << desc << '\n';
+    return 1;
+  }
+  catch (const std::exception &error) {
+    std::clog << "Error: " << error.what() << '\n';
+    return 1;
+  }
+}